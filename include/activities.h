@@ -1,7 +1,13 @@
 #ifndef ACTIVITIES_H
 #define ACTIVITIES_H
 
+#include "records.h"
+
 // argv-based builtin handler for `activities` command.
 int run_activities_argv(int argc, char **argv);
 
+// Same, but fill t with one record per process (pid, name, state) for a
+// following record filter (records.h). *as_json is set by -j.
+int activities_records(int argc, char **argv, RecTable *t, int *as_json);
+
 #endif // ACTIVITIES_H
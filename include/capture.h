@@ -0,0 +1,31 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <sys/types.h>
+
+// last [on|off|clear]
+// With `last on`, the stdout of each foreground pipeline that would go to the
+// terminal is also kept by the shell; plain `last` writes it out again, e.g.
+// `last | grep err` or `last > out.txt`. Returns 0, or 1 on bad syntax.
+// Captured stages write to a pipe, so programs that need the terminal as
+// their stdout (editors, pagers, top) misbehave while `last on` is set.
+int run_last_argv(int argc, char **argv);
+
+// Executor side. capture_start() returns a new memfd for the next foreground
+// pipeline, or -1 when capturing is off. Its last stage then writes into a
+// pipe read by a helper process running capture_pump(), which copies to out
+// and into the memfd. capture_finish() makes that memfd the one `last`
+// replays (it takes ownership).
+int capture_start(void);
+void capture_pump(int in, int out, int memfd);
+void capture_finish(int memfd);
+
+// Turn capturing off and drop the last capture (a fresh shell has neither).
+void capture_reset(void);
+
+// Capture state of one embedded session (see myshell.c). capture_swap(s)
+// exchanges the live state and *s; a fresh session starts as { 0, -1 }.
+typedef struct { int enabled; int last_fd; } CaptureState;
+void capture_swap(CaptureState *s);
+
+#endif // CAPTURE_H
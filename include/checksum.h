@@ -0,0 +1,10 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+// checksum [-a xxh64|crc32c] [-c] [file...]
+// Print "<hash>  <file>" lines (the *sum format) for each file, or with -c
+// verify files listed in such lines. Returns 0 if all files were read (and
+// matched), 1 otherwise.
+int run_checksum_argv(int argc, char **argv);
+
+#endif // CHECKSUM_H
@@ -0,0 +1,9 @@
+#ifndef COPY_H
+#define COPY_H
+
+// copy [-v] src... dst
+// Copy files and directory trees (like cp -r -p) with a pool of threads.
+// -v prints a summary. Returns 0 on success, 1 if anything failed.
+int run_copy_argv(int argc, char **argv);
+
+#endif // COPY_H
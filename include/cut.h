@@ -0,0 +1,9 @@
+#ifndef CUT_H
+#define CUT_H
+
+// cut -b list [file...]  |  cut -f list [-d delim] [-s] [file...]
+// Print selected bytes or fields of each line. Returns 0, or 1 if a file
+// could not be read.
+int run_cut_argv(int argc, char **argv);
+
+#endif // CUT_H
@@ -0,0 +1,44 @@
+// dirs.h - directory file descriptors for cwd, shell home and previous dir
+#ifndef DIRS_H
+#define DIRS_H
+
+// The shell keeps O_PATH descriptors for the three directories builtins
+// refer to most. Relative lookups go through openat()/fstatat() against
+// them, and 'hop -' / 'reveal -' keep working if the directory is renamed.
+// All descriptors are close-on-exec.
+
+// Open the cwd descriptor (home is set by prompt.c via dirs_set_home()).
+void dirs_init(void);
+
+// Descriptors; cwd falls back to AT_FDCWD, home/prev return -1 when unknown.
+int dirs_cwd_fd(void);
+int dirs_home_fd(void);
+int dirs_prev_fd(void);
+
+// (Re)open the home descriptor from a path.
+void dirs_set_home(const char *path);
+
+// Change directory to path resolved relative to base (an fd from above or
+// AT_FDCWD). On success the old cwd becomes the previous directory when
+// record_prev is set. Returns 0 on success, -1 if the target isn't usable.
+int dirs_chdir_at(int base, const char *path, int record_prev);
+
+// Swap cwd and previous directory ('hop -'). Returns 0, or -1 if there is no
+// previous directory or it can no longer be entered.
+int dirs_swap_prev(void);
+
+// Replace the previous directory by path (NULL forgets it).
+void dirs_set_prev_path(const char *path);
+
+// Current path of the previous directory (follows renames), or NULL.
+// Points to a static buffer overwritten by the next call.
+const char *dirs_prev_path(void);
+
+// Reopen the cwd descriptor after someone else called chdir().
+void dirs_sync_cwd(void);
+
+// Open path relative to base as a readable directory (for fdopendir()).
+// Returns an fd or -1.
+int dirs_open_dir(int base, const char *path);
+
+#endif // DIRS_H
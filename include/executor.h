@@ -23,6 +23,9 @@ int executor_for_each_activity(int (*cb)(pid_t pid, const char *name, int stoppe
 // before printing the next prompt to avoid racey interleaving.
 int executor_recent_stop(void);
 
+// True if name is a shell builtin (hop, reveal, log, ...).
+bool executor_is_builtin(const char *name);
+
 // Job control APIs moved to jobs.h (executor now only executes pipelines & delegates job mgmt)
 
 #endif // EXECUTOR_H
@@ -0,0 +1,15 @@
+// expand.h - brace expansion for command words
+#ifndef EXPAND_H
+#define EXPAND_H
+
+// Callback receiving one expanded word. Return non-zero to stop expanding.
+typedef int (*expand_emit_fn)(const char *word, void *ud);
+
+// Expand {a,b,c} lists and {first..last[..step]} ranges (integers or single
+// letters) in word, bash-style, calling emit once per resulting word in
+// order. Words without a valid brace expression are emitted unchanged.
+// Ranges are generated one value at a time, never as a list.
+// Returns 0 when done, or the non-zero value returned by emit.
+int expand_braces(const char *word, expand_emit_fn emit, void *ud);
+
+#endif // EXPAND_H
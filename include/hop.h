@@ -24,5 +24,8 @@ int run_cd_argv(int argc, char **argv);
 int hop_prev_cwd_available(void);
 // Returns a const pointer to the previous CWD string if available, otherwise NULL.
 const char* hop_get_prev_cwd(void);
+// Overwrite the previous CWD (NULL forgets it). Used when library contexts
+// swap their session state in and out.
+void hop_set_prev_cwd(const char *path);
 
 #endif // HOP_H
@@ -0,0 +1,23 @@
+// intern.h - shared table of immutable, reference-counted strings
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+// An interned string is a plain const char * that points into the table:
+// equal contents always give the same pointer, so handles compare with ==.
+// Never modify or free() one; give it back with intern_release().
+// Not thread-safe: only the main shell thread may use it.
+
+// Handle for s (or its first n bytes), adding a reference. Returns NULL only
+// when out of memory.
+const char *intern(const char *s);
+const char *intern_n(const char *s, size_t n);
+
+// Add a reference to an existing handle and return it (NULL passes through).
+const char *intern_ref(const char *is);
+
+// Drop a reference; the string is freed with its last one. NULL is ignored.
+void intern_release(const char *is);
+
+#endif // INTERN_H
@@ -3,7 +3,8 @@
 #define JOBS_H
 #include <sys/types.h>
 
-// Poll background jobs for completion (printing exit messages)
+// Poll background jobs for completion. Exit messages are printed in one
+// batch, collapsed into a summary line past $JOBS_NOTIFY_MAX (default 16).
 void jobs_poll(void);
 
 // Enumerate current activities (running or stopped pipeline stages)
@@ -14,13 +15,46 @@ void jobs_set_foreground(pid_t pgid, const pid_t *pids, int count, const char *n
 void jobs_clear_foreground(void);
 int  jobs_get_foreground(pid_t *pgid_out, pid_t *pids_out, int max, char *name_buf, size_t name_buf_sz);
 int  jobs_move_foreground_to_background_stopped(void); // returns job number or -1
+// Same, for a pipeline that may still be running (autobg, see setopt.c):
+// stages are marked stopped only if stopped != 0, and stages with a non-zero
+// reaped[i] (already waited for; reaped may be NULL) count as finished.
+int  jobs_move_foreground_to_background(int stopped, const int *reaped);
 
 // Register a new background job with given pids and per-stage names.
 // Returns job number, fills last_pid_out with pid of last stage.
 int jobs_add_background(const pid_t *pids, int count, const char *const *stage_names, pid_t *last_pid_out);
 
+// Live stages of job jobnum (0 = most recent) with their pidfds (-1 if
+// none). The pidfds stay owned by the job table. Returns the number of
+// stages written, or -1 if there is no such job.
+int jobs_job_targets(int jobnum, pid_t *pids_out, int *pidfds_out, int max);
+
 // Builtin helpers (return shell status codes)
 int jobs_cmd_fg(int jobnum);
 int jobs_cmd_bg(int jobnum);
+// notices: list recently finished jobs (up to 1024); clear != 0 forgets them.
+int jobs_cmd_notices(int clear);
+
+// The background jobs, their notices and job numbers. One table is live;
+// an embedded shell (myshell.c) keeps one per context and swaps it in with
+// jobs_table_swap(t), which exchanges the live table and *t, around every
+// call. jobs_table_free() drops a table's jobs without signalling them.
+typedef struct JobTable JobTable;
+JobTable *jobs_table_new(void); // NULL if out of memory
+void jobs_table_swap(JobTable *t);
+void jobs_table_free(JobTable *t);
+
+// Foreground jobs get the terminal with tcsetpgrp() (jobs_give_terminal)
+// and the shell takes it back afterwards. An embedded shell turns this off:
+// a host that does not ignore SIGTTOU would be stopped taking it back, and
+// the terminal is not the library's to give. Both are no-ops then.
+void jobs_set_terminal_control(int on);
+int  jobs_terminal_control(void);
+void jobs_give_terminal(pid_t pgid);
+void jobs_take_terminal(void);
+
+// Drop every job and notice without signalling anyone: a forked child that
+// goes on as a fresh shell (script.c) must not manage its parent's jobs.
+void jobs_forget_all(void);
 
 #endif // JOBS_H
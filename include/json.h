@@ -0,0 +1,27 @@
+// json.h - streaming NDJSON writer for machine-readable builtin output
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+#include "outbuf.h"
+
+// A writer appends straight into an OutBuf (see outbuf.h): no heap
+// allocations. Records are emitted one per line (NDJSON) and the buffer is
+// written out whenever it fills up, so listings of any size stream through.
+typedef struct {
+    OutBuf *out;     // destination buffer
+    int need_comma;  // inside a record: a field was already written
+} JsonWriter;
+
+// Global default set by `shell.out --json`; builtins also accept -j.
+void json_set_default(int on);
+int  json_default(void);
+
+void json_init(JsonWriter *w, OutBuf *out);
+void json_begin(JsonWriter *w);                                  // {
+void json_str(JsonWriter *w, const char *key, const char *val);  // "key":"escaped"
+void json_int(JsonWriter *w, const char *key, long long val);    // "key":123
+void json_end(JsonWriter *w);                                    // }\n
+void json_flush(JsonWriter *w);
+
+#endif // JSON_H
@@ -0,0 +1,39 @@
+// lineread.h - record reader shared by the REPL and the read builtin
+#ifndef LINEREAD_H
+#define LINEREAD_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Read one record (up to and including delim) from fd into *buf (grown with
+// realloc as needed; *cap is its size). The delimiter is stripped and the
+// result NUL-terminated; *len receives its length.
+// Returns 1 for a complete record, 0 for a final record without delimiter,
+// -1 at end of input (nothing read) and -2 on error (e.g. EINTR).
+//
+// Seekable inputs are read in large blocks and the file offset is moved
+// back to just after the delimiter, so the next reader (or a child process
+// sharing the descriptor) starts exactly at the next record. Pipes and
+// terminals keep their read-ahead in a buffer owned by the shell and keyed by
+// the open file, so every record is delivered exactly once.
+int lr_read_record(int fd, int delim, char **buf, size_t *cap, size_t *len);
+
+// Read many records at once into *buf: everything up to end of input, or
+// only the first max records when max > 0. Delimiters are kept and *len is
+// the total byte count (NUL-terminated). Input is read in large blocks
+// straight into *buf, and anything read past the last wanted record is given
+// back like lr_read_record does. Returns 0, or -2 on error (*buf then holds
+// what was read so far).
+int lr_read_bulk(int fd, int delim, size_t max, char **buf, size_t *cap, size_t *len);
+
+// Read up to n bytes for a streaming filter (tr, cut). Read-ahead the shell
+// holds for a pipe or terminal is handed out first, so a filter reading the
+// shell's own input sees it in order. Returns the byte count, 0 at end of
+// input and -2 on error (e.g. EINTR).
+ssize_t lr_read_block(int fd, char *buf, size_t n);
+
+// Drop all buffered read-ahead. For a forked child that goes on as a fresh
+// shell: those bytes belong to the parent, which will still read them.
+void lr_forget_buffered(void);
+
+#endif // LINEREAD_H
@@ -0,0 +1,9 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+// mapfile [-t] [-d delim] [-n count] [-s skip] [name]
+// Read lines from stdin into the indexed array name (default MAPFILE).
+// Returns 0 on success, 1 on error.
+int run_mapfile_argv(int argc, char **argv);
+
+#endif // MAPFILE_H
@@ -0,0 +1,10 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+// memo [--dep file]... [--env VAR]... command [args...]
+// Run command, or replay its stored stdout/stderr/exit status when argv, cwd,
+// the selected environment variables and the dependency files are unchanged.
+// Returns the command's exit status.
+int run_memo_argv(int argc, char **argv);
+
+#endif // MEMO_H
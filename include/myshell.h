@@ -0,0 +1,39 @@
+// myshell.h - embeddable shell library API (libmyshell)
+#ifndef MYSHELL_H
+#define MYSHELL_H
+
+#include <stddef.h>
+
+// Opaque shell context. Each context owns its own session state (home, current
+// and previous directory, background jobs and their numbers, shell variables,
+// `last` output) which is swapped in for the duration of every call, so
+// several contexts can be used from the same host program one after the
+// other. Jobs never get the terminal. The
+// library is not thread-safe: do not call into it concurrently.
+typedef struct MyShell MyShell;
+
+// Flags for myshell_create()
+#define MYSHELL_HISTORY 0x1 // load/store ~/.myshell_history like the interactive shell
+
+// Output callback: receives captured output of one myshell_exec() call.
+// fd is 1 for stdout and 2 for stderr; data is not NUL-terminated.
+typedef void (*myshell_output_cb)(int fd, const char *data, size_t len, void *ud);
+
+// Create a context. home is the directory that '~' refers to (NULL -> the
+// current working directory). Returns NULL on allocation failure.
+MyShell *myshell_create(const char *home, int flags);
+
+// Execute one command line (same grammar as the interactive shell).
+// If cb is non-NULL, stdout/stderr of the line are captured and passed to it;
+// otherwise output goes to the host's stdout/stderr.
+// Returns the status of the last command group, or -1 on invalid syntax.
+int myshell_exec(MyShell *sh, const char *line, myshell_output_cb cb, void *ud);
+
+// Reap finished background jobs (completion messages go to stdout).
+// Returns the number of job stages that are still running or stopped.
+int myshell_poll_jobs(MyShell *sh);
+
+// Destroy the context. Remaining background jobs are left running.
+void myshell_destroy(MyShell *sh);
+
+#endif // MYSHELL_H
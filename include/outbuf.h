@@ -0,0 +1,34 @@
+// outbuf.h - buffered output layer shared by all builtins
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stddef.h>
+
+// One buffer per file descriptor (stdout and stderr). Builtins append to it
+// instead of calling puts/printf; the buffer is written with as few
+// write(2)/writev(2) calls as possible.
+typedef struct OutBuf OutBuf;
+
+OutBuf *out_stdout(void);
+OutBuf *out_stderr(void);
+
+void out_write(OutBuf *o, const char *s, size_t n);
+void out_puts(OutBuf *o, const char *s);   // like puts(): appends '\n'
+void out_fputs(OutBuf *o, const char *s);  // like fputs(): no newline
+void out_putc(OutBuf *o, char c);
+void out_printf(OutBuf *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Write out pending bytes of one buffer.
+void out_flush(OutBuf *o);
+
+// Flush stdio and every OutBuf. Must be called before fork() (so nothing is
+// duplicated in the child) and before _exit() in a child that ran a builtin
+// (so nothing is lost). Also forgets the cached tty/pipe detection, because
+// callers typically dup2() new descriptors over 1/2 right afterwards.
+void out_flush_all(void);
+
+// 1 if the descriptor behind o is a terminal (output is then kept small and
+// flushed promptly), 0 for pipes and files.
+int out_is_tty(OutBuf *o);
+
+#endif // OUTBUF_H
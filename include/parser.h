@@ -7,4 +7,12 @@
 // Whitespace between tokens (space, tab, CR, LF) is ignored.
 int parse_command(const char *s);
 
+// Validate s like parse_command() and call fn with the command name (first
+// word, len bytes, not NUL-terminated) of every atomic command, left to
+// right, in the same single pass. Returns 0 for a valid line, -1 for invalid
+// syntax (names before the error may already have been reported), or the
+// first non-zero value returned by fn, which stops the scan. fn may be NULL.
+typedef int (*parse_name_fn)(const char *name, size_t len, void *ud);
+int parse_command_names(const char *s, parse_name_fn fn, void *ud);
+
 #endif // PARSER_H
@@ -1,7 +1,8 @@
 #ifndef PING_H
 #define PING_H
 #include <stdbool.h>
-// argv-based handler: ping <pid> <signal_number>
+// argv-based handler: ping [--wait] <target>... <signal>
+// target: pid, %job, -pgid or @name-pattern; signal: number or name.
 // Returns 0 on success, non-zero on error.
 int run_ping_argv(int argc, char **argv);
 // Line-based quick detection (optional, not used now)
@@ -0,0 +1,22 @@
+// prewarm.h - cached PATH lookups and idle-time prefetch of frequent commands
+#ifndef PREWARM_H
+#define PREWARM_H
+
+// Load the command usage counts kept in $HOME/.myshell_prewarm.
+void prewarm_init(void);
+
+// Count the command names of an accepted input line (builtins excluded).
+void prewarm_learn(const char *line);
+
+// Called while the shell waits at an interactive prompt: ask the kernel to
+// read the most frequently used executables into the page cache, and save
+// the usage counts if they changed.
+void prewarm_idle(void);
+
+// Full path of the executable 'name' as found in $PATH, cached until $PATH
+// changes. Returns NULL if name contains '/' or isn't found (callers then
+// fall back to execvp()). The string stays valid until the next call that
+// adds a name (a full table drops rarely used entries) or $PATH changes.
+const char *prewarm_resolve(const char *name);
+
+#endif // PREWARM_H
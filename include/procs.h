@@ -0,0 +1,33 @@
+// procs.h - process helpers: pidfds and a cached /proc scan
+#ifndef PROCS_H
+#define PROCS_H
+
+#include <sys/types.h>
+
+// Open a pidfd for pid (close-on-exec). Returns -1 if the process is gone or
+// the kernel has no pidfd support.
+int procs_pidfd_open(pid_t pid);
+
+// Deliver sig through pidfd when one is available (immune to pid reuse),
+// otherwise fall back to kill(pid). Returns 0 or -1 with errno set.
+int procs_send(pid_t pid, int pidfd, int sig);
+
+// Block until every pidfd in the list becomes readable (process exited).
+// Negative entries are skipped. Returns -1 if Ctrl-C ended the wait, else 0.
+int procs_wait(const int *pidfds, int n);
+
+typedef struct {
+    pid_t pid;
+    pid_t pgid;
+    char comm[32]; // /proc/<pid>/comm (kernel truncates to 15 chars)
+} ProcInfo;
+
+// Snapshot of all processes, refreshed at most every PROCS_CACHE_MS.
+// The array is owned by the module. Returns the number of entries.
+#define PROCS_CACHE_MS 500
+int procs_scan(const ProcInfo **out);
+
+// Forget the cached snapshot (e.g. after sending signals).
+void procs_invalidate(void);
+
+#endif // PROCS_H
@@ -8,4 +8,8 @@ void prompt_cleanup(void); // Clean up any heap allocations used by the prompt m
 // Returns the shell's home directory as determined at startup.
 // Never free this pointer. May return NULL in pathological cases.
 const char* prompt_home(void);
+
+// Replace the shell's home directory (used by library contexts, see myshell.h).
+// A copy of path is kept; NULL is ignored.
+void prompt_set_home(const char *path);
 #endif
\ No newline at end of file
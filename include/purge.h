@@ -0,0 +1,9 @@
+#ifndef PURGE_H
+#define PURGE_H
+
+// purge-tree [-v] path...
+// Remove files and whole directory trees (like rm -rf) with a pool of
+// threads. -v prints a summary. Returns 0 on success, 1 if anything was left.
+int run_purge_tree_argv(int argc, char **argv);
+
+#endif // PURGE_H
@@ -0,0 +1,9 @@
+#ifndef READ_H
+#define READ_H
+
+// read [-r] [-d delim] [name...]
+// Read one record from stdin and split it into shell variables (vars.h).
+// Returns 0 on success, 1 at end of input.
+int run_read_argv(int argc, char **argv);
+
+#endif // READ_H
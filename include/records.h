@@ -0,0 +1,35 @@
+// records.h - typed records passed between builtins of one pipeline
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <stddef.h>
+
+// A table of records with named columns. Values are integers or strings;
+// a record may lack a column. Strings are copied into the table's arena.
+typedef struct RecTable RecTable;
+
+#define REC_MAX_COLS 32
+
+// Column index for name, adding the column if new. -1 if there are
+// already REC_MAX_COLS columns.
+int  rec_column(RecTable *t, const char *name);
+
+// Start a new record; the setters below fill its columns.
+void rec_add(RecTable *t);
+void rec_set_int(RecTable *t, int col, long long v);
+void rec_set_str(RecTable *t, int col, const char *s);
+
+// where field op value | sortby [-r] field... | select field...
+// Builtin entry for the record filters, and for a joined chain of record
+// stages: the words of each stage separated by "|" words (see
+// records_joinable). Records come from the producer at its head, or are read
+// from stdin as NDJSON (other lines become {"line": text}). They are printed
+// once, at the end: tab-separated columns, or NDJSON with -j/--json.
+int run_records_argv(int argc, char **argv);
+
+// 1 if a stage running name can take records from the stage before it.
+int records_is_filter(const char *name);
+// 1 if a stage running name can hand records to a following filter.
+int records_joinable(const char *name);
+
+#endif // RECORDS_H
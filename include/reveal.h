@@ -2,6 +2,7 @@
 #define REVEAL_H
 
 #include <stdbool.h>
+#include "records.h"
 
 // Handle a 'reveal' command line.
 // Returns true if the input started with 'reveal' and was handled (even if it prints an error), false otherwise.
@@ -10,4 +11,8 @@ bool try_handle_reveal(const char *input);
 // argv-based execution for pipeline/redirection integration.
 int run_reveal_argv(int argc, char **argv);
 
+// Same arguments, but fill t with one record per entry (name, type, size,
+// mtime) for a following record filter (records.h). *as_json is set by -j.
+int reveal_records(int argc, char **argv, RecTable *t, int *as_json);
+
 #endif // REVEAL_H
@@ -0,0 +1,26 @@
+// script.h - command files, and nested runs of this shell without exec
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+// Index of the command file in a shell.out argument vector (options such as
+// --json skipped), or -1 when there is none or --serve was given.
+int script_arg_index(char **argv);
+
+// Run the command lines of the file at path (relative to the cwd) without
+// prompt, history or terminal takeover. Returns the status of the last line,
+// or 127 if the file can't be opened.
+int script_run_file(const char *path);
+
+// Remember which binary this shell is (call once at startup; without it
+// script_is_self() always says no, e.g. inside libmyshell hosts).
+void script_init_self(void);
+
+// 1 if running path (an executable found for argv[0], may be NULL) with
+// argv would start this same shell binary on a command file.
+int script_is_self(const char *path, char **argv);
+
+// In a forked child: reset the state a freshly exec'd shell would not have,
+// run argv's command file and _exit() with its status.
+void script_run_inline(char **argv) __attribute__((noreturn));
+
+#endif // SCRIPT_H
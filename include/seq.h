@@ -0,0 +1,8 @@
+#ifndef SEQ_H
+#define SEQ_H
+
+// seq [-w] [-s sep] [first [incr]] last
+// Print integers from first (default 1) to last in steps of incr (default 1).
+int run_seq_argv(int argc, char **argv);
+
+#endif // SEQ_H
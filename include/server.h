@@ -0,0 +1,38 @@
+// server.h - command-server daemon mode (shell.out --serve /path.sock)
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdint.h>
+
+// Wire protocol over a SOCK_STREAM Unix domain socket. A client may send any
+// number of requests on one connection; each gets exactly one response.
+//
+// Request:  ServerReqHdr, then line_len bytes of command line, then cwd_len
+//           bytes of working directory (cwd_len may be 0 = shell home).
+//           The header may carry up to 3 descriptors via SCM_RIGHTS; they
+//           become the command's stdin, stdout and stderr in that order
+//           (missing ones default to /dev/null).
+// Response: ServerRespHdr with the status of the last command group and the
+//           wall-clock time spent executing the line.
+#define SERVER_MAGIC 0x3148534dU // "MSH1" little-endian
+#define SERVER_MAX_LINE 65536
+#define SERVER_DEFAULT_WORKERS 4
+
+typedef struct {
+    uint32_t magic;
+    uint32_t line_len;
+    uint32_t cwd_len;
+} ServerReqHdr;
+
+typedef struct {
+    uint32_t magic;
+    int32_t status;       // -1 on invalid syntax / malformed request
+    uint64_t elapsed_ns;  // time spent in the executor
+} ServerRespHdr;
+
+// Run the daemon: bind sock_path, pre-fork `workers` initialized shell
+// sessions that accept connections, and supervise them until SIGINT/SIGTERM.
+// Returns the process exit status.
+int server_run(const char *sock_path, int workers);
+
+#endif // SERVER_H
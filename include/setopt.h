@@ -0,0 +1,16 @@
+#ifndef SETOPT_H
+#define SETOPT_H
+
+// setopt [name [value]]
+// Shell options. With no arguments, list every option and its value.
+//   autobg 30s|2m|1h|off  move a foreground pipeline that runs longer than
+//                         this to the background, still running
+int run_setopt_argv(int argc, char **argv);
+
+// Seconds after which a foreground pipeline is backgrounded (0 = never).
+unsigned setopt_autobg_seconds(void);
+
+// Back to the defaults (a nested shell starts fresh; see script.c).
+void setopt_reset(void);
+
+#endif // SETOPT_H
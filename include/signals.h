@@ -7,4 +7,14 @@ void signals_init(void);
 void signals_process_pending(void);
 void signals_reset_for_child(void);
 
+// 1 if Ctrl-C arrived since the last call (then clears it). Long-running
+// in-process builtins poll this to stop early.
+int signals_take_interrupt(void);
+
+// Deliver SIGALRM after secs seconds (0 cancels), interrupting blocking
+// calls with EINTR; signals_take_alarm() then returns 1. Until cancelled it
+// repeats every 100 ms, so checking the flag and then blocking cannot miss it.
+void signals_alarm(unsigned secs);
+int signals_take_alarm(void);
+
 #endif // SIGNALS_H
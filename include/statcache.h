@@ -0,0 +1,18 @@
+// statcache.h - short-lived stat() cache shared by builtins and lookups
+#ifndef STATCACHE_H
+#define STATCACHE_H
+
+#include <sys/stat.h>
+
+// fstatat() through the cache. dirfd must be AT_FDCWD or a descriptor that
+// keeps naming the same directory until the next statcache_invalidate()
+// (the dirs.h descriptors do). flags may hold AT_SYMLINK_NOFOLLOW. Failures
+// are cached too. Returns 0, or -1 with errno set, like fstatat().
+int statcache_stat(int dirfd, const char *name, struct stat *st, int flags);
+
+// Forget everything. Called at the start of each command line, after any
+// command ran outside the shell process, and by in-shell operations that
+// change the filesystem or the directories behind the descriptors.
+void statcache_invalidate(void);
+
+#endif // STATCACHE_H
@@ -0,0 +1,9 @@
+#ifndef SYSCOUNT_H
+#define SYSCOUNT_H
+
+// syscount cmd [args...]
+// Run cmd under a ptrace tracer (following forks) and print a per-syscall
+// table of calls, errors and time on stderr. Returns cmd's exit status.
+int run_syscount_argv(int argc, char **argv);
+
+#endif // SYSCOUNT_H
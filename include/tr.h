@@ -0,0 +1,9 @@
+#ifndef TR_H
+#define TR_H
+
+// tr [-c] [-d] [-s] set1 [set2]
+// Translate, delete or squeeze bytes from stdin to stdout. Returns 0, or 1
+// on a syntax or read error.
+int run_tr_argv(int argc, char **argv);
+
+#endif // TR_H
@@ -0,0 +1,10 @@
+#ifndef USAGE_H
+#define USAGE_H
+
+// usage [-b] [-f] [-j] [path...]
+// Print the disk space allocated under each path (default: .), like du -s.
+// -b prints the apparent size (sum of file sizes) in bytes, like du -sb;
+// -f ignores the directory cache, -j prints NDJSON.
+int run_usage_argv(int argc, char **argv);
+
+#endif // USAGE_H
@@ -0,0 +1,51 @@
+// vars.h - shell variables and $NAME expansion
+#ifndef VARS_H
+#define VARS_H
+
+#include <stddef.h>
+
+// Set (copying name and value) or replace a shell variable.
+void vars_set(const char *name, const char *value);
+
+// Replace name with an indexed array, taking ownership of data and offs
+// (both malloc'd). Element i is data[offs[i]..offs[i+1]) minus one trailing
+// byte equal to trim (pass -1 to keep elements as they are).
+void vars_set_array(const char *name, char *data, size_t *offs, size_t count, int trim);
+
+// Value of a scalar shell variable, falling back to the environment; NULL
+// if unset or an array.
+const char *vars_get(const char *name);
+
+// Element i of a variable (a scalar is element 0); *len gets its length,
+// which is not NUL-terminated for arrays. NULL when out of range or unset.
+const char *vars_get_elem(const char *name, size_t i, size_t *len);
+
+// Number of elements: 0 if unset, 1 for a scalar.
+size_t vars_count(const char *name);
+
+// Forget every shell variable (the environment is left alone).
+void vars_clear(void);
+
+// Variables of one embedded session (see myshell.c). The embedder keeps a
+// table per session and calls vars_table_swap(t), which exchanges the live
+// variables and *t, around every call. vars_table_free() forgets a table.
+typedef struct VarTable VarTable;
+VarTable *vars_table_new(void); // NULL if out of memory
+void vars_table_swap(VarTable *t);
+void vars_table_free(VarTable *t);
+
+// 1 if name is a valid variable name ([A-Za-z_][A-Za-z0-9_]*).
+int vars_valid_name(const char *name);
+
+// Replace $NAME, ${NAME}, ${#NAME}, ${NAME[i]}, ${NAME[@]} and ${#NAME[@]}
+// in word with their values (unset = empty). Returns a new heap string, or
+// NULL when word has no '$' (use it as is).
+char *vars_expand(const char *word);
+
+// If word is exactly ${NAME[@]}, call emit for each element (one word per
+// element) and return 0, or the first non-zero emit result. Returns -1 for
+// any other word.
+typedef int (*vars_emit_fn)(const char *s, size_t len, void *ud);
+int vars_expand_each(const char *word, vars_emit_fn emit, void *ud);
+
+#endif // VARS_H
@@ -4,14 +4,21 @@
 // job system (both running and stopped pipeline stages).
 // The executor provides an iterator (executor_for_each_activity) that we use
 // to collect snapshot information and then print a sorted list.
+// `activities -j` (or `shell.out --json`) prints one JSON object per process.
+// Piped into a record filter (where, sortby, select) the same fields are
+// passed on as typed records instead (records.c).
 
 #include "activities.h"
 #include "executor.h"
+#include "json.h"
+#include "outbuf.h"
+#include "intern.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
-typedef struct { pid_t pid; char *name; int stopped; } Act;
+typedef struct { pid_t pid; const char *name; int stopped; } Act; // name is interned
 
 static int collect_cb(pid_t pid, const char *name, int stopped, void *ud){
     Act **arrp = (Act**)ud;
@@ -23,32 +30,67 @@ static int collect_cb(pid_t pid, const char *name, int stopped, void *ud){
     }
     if(len >= cap){ cap*=2; arr = realloc(arr, sizeof(Act)*cap); *arrp = arr; }
     arr[len].pid = pid;
-    arr[len].name = strdup(name ? name : "?");
+    arr[len].name = intern(name ? name : "?"); // the job table holds the same handle
     arr[len].stopped = stopped;
     len++;
     return 0;
 }
 
-int run_activities_argv(int argc, char **argv){
-    (void)argc; (void)argv;
+// By name, then pid. Equal interned names are the same pointer.
+static int cmp_act(const void *a, const void *b){
+    const Act *x = a, *y = b;
+    int cmp = x->name == y->name ? 0 : strcmp(x->name, y->name);
+    if (cmp) return cmp;
+    return (x->pid > y->pid) - (x->pid < y->pid);
+}
+
+// Snapshot of the tracked processes, sorted; NULL (and 0) if there are none.
+static Act *collect(int *total){
     Act *acts=NULL;
-    int total = executor_for_each_activity(collect_cb, &acts);
-    if(total <= 0){
-        free(acts); return 0; // nothing to print
-    }
+    *total = executor_for_each_activity(collect_cb, &acts);
+    if(*total <= 0){ free(acts); return NULL; }
     // Determine actual length stored in static collector state (hacky). We'll pass total.
-    // Sort
+    qsort(acts, (size_t)*total, sizeof(Act), cmp_act);
+    return acts;
+}
+
+int run_activities_argv(int argc, char **argv){
+    int as_json = json_default();
+    for(int i=1;i<argc;i++) if(strcmp(argv[i], "-j")==0) as_json = 1;
+    int total;
+    Act *acts = collect(&total);
+    if(!acts) return 0; // nothing to print
+    JsonWriter jw;
+    if(as_json) json_init(&jw, out_stdout());
     for(int i=0;i<total;i++){
-        for(int j=i+1;j<total;j++){
-            int cmp = strcmp(acts[i].name, acts[j].name);
-            if(cmp>0 || (cmp==0 && acts[i].pid > acts[j].pid)){
-                Act tmp = acts[i]; acts[i]=acts[j]; acts[j]=tmp;
-            }
+        const char *state = acts[i].stopped?"Stopped":"Running";
+        if(as_json){
+            json_begin(&jw);
+            json_int(&jw, "pid", acts[i].pid);
+            json_str(&jw, "name", acts[i].name);
+            json_str(&jw, "state", state);
+            json_end(&jw);
+        } else {
+            out_printf(out_stdout(), "[%d] : %s - %s\n", acts[i].pid, acts[i].name, state);
         }
+        intern_release(acts[i].name);
     }
-    for(int i=0;i<total;i++){
-        printf("[%d] : %s - %s\n", acts[i].pid, acts[i].name, acts[i].stopped?"Stopped":"Running");
-        free(acts[i].name);
+    if(as_json) json_flush(&jw);
+    free(acts);
+    return 0;
+}
+
+int activities_records(int argc, char **argv, RecTable *t, int *as_json){
+    for(int i=1;i<argc;i++) if(strcmp(argv[i], "-j")==0) *as_json = 1;
+    int pid = rec_column(t, "pid"), name = rec_column(t, "name"), state = rec_column(t, "state");
+    int total;
+    Act *acts = collect(&total);
+    for(int i=0;i<total && acts;i++){
+        rec_add(t);
+        rec_set_int(t, pid, acts[i].pid);
+        rec_set_str(t, name, acts[i].name);
+        rec_set_str(t, state, acts[i].stopped?"Stopped":"Running");
+        intern_release(acts[i].name);
     }
     free(acts);
     return 0;
@@ -0,0 +1,205 @@
+// capture.c: keep the last command's output for `last`
+// -----------------------------------------------------
+// Implements: last [on|off|clear]
+//   last on            -> start keeping foreground output (off by default)
+//   make 2>&1          -> runs and prints as usual ...
+//   last | grep error  -> ... and can be looked at again without rerunning
+//   last > build.log   -> or saved
+// Only output that would reach the terminal is kept: a pipeline whose last
+// stage writes to a file is not captured. Builtins run inside the shell are
+// not captured either.
+// Limitation: while capturing, the last stage's stdout is a pipe, not the
+// terminal. Full-screen and other terminal programs (vi, less, top, ssh)
+// see isatty(1) fail, drop colours or refuse to run; use `last off` for them.
+//
+// The last stage writes into a pipe. A helper process in the job's process
+// group (so Ctrl-Z and fg treat it like any other stage) moves the data on
+// without copying it through user space where the kernel allows it:
+// - tee() duplicates what is in the pipe into a second pipe, and splice()
+//   moves that copy into a memfd;
+// - splice() moves the original on to stdout, falling back to read/write for
+//   terminals, which do not accept splice.
+// The memfd is a ring of CAPTURE_MAX bytes behind an 8-byte header holding
+// the total byte count, so a huge output keeps only its tail. Each pipeline
+// gets a fresh memfd, so `last | less` still reads the previous output while
+// its own output is being captured.
+#define _GNU_SOURCE
+#include "capture.h"
+#include "outbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+
+#define CAPTURE_MAX (8u << 20) // bytes kept per command
+#define CAPTURE_HDR 8          // uint64_t total bytes seen
+
+static int enabled = 0;
+static int last_fd = -1;       // memfd of the last captured pipeline
+
+int capture_start(void){
+    if (!enabled) return -1;
+    int fd = memfd_create("myshell-last", MFD_CLOEXEC);
+    if (fd < 0) return -1;
+    uint64_t zero = 0;
+    if (pwrite(fd, &zero, sizeof(zero), 0) != (ssize_t)sizeof(zero)) { close(fd); return -1; }
+    return fd;
+}
+
+void capture_finish(int memfd){
+    if (memfd < 0) return;
+    if (last_fd >= 0) close(last_fd);
+    last_fd = memfd;
+}
+
+void capture_reset(void){
+    enabled = 0;
+    if (last_fd >= 0) close(last_fd);
+    last_fd = -1;
+}
+
+void capture_swap(CaptureState *s){
+    CaptureState live = { enabled, last_fd };
+    enabled = s->enabled;
+    last_fd = s->last_fd;
+    *s = live;
+}
+
+static int write_all(int fd, const char *p, size_t n){
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) { if (errno == EINTR) continue; return -1; }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+// Move n bytes from pipe `from` into the ring at logical position total.
+static void to_ring(int from, int memfd, uint64_t total, size_t n){
+    while (n > 0) {
+        size_t pos = (size_t)(total % CAPTURE_MAX);
+        size_t room = CAPTURE_MAX - pos;
+        loff_t off = CAPTURE_HDR + (loff_t)pos;
+        ssize_t m = splice(from, NULL, memfd, &off, n < room ? n : room, SPLICE_F_MOVE);
+        if (m <= 0) {
+            if (m < 0 && errno == EINTR) continue;
+            char sink[4096]; // can't store it: drop it so the pipe doesn't fill up
+            ssize_t r = read(from, sink, n < sizeof(sink) ? n : sizeof(sink));
+            if (r <= 0) return;
+            m = r;
+        }
+        total += (uint64_t)m;
+        n -= (size_t)m;
+    }
+}
+
+// Store n bytes of buf in the ring at logical position total.
+static void store(int memfd, uint64_t total, const char *buf, size_t n){
+    size_t pos = (size_t)(total % CAPTURE_MAX), k = n < CAPTURE_MAX - pos ? n : CAPTURE_MAX - pos;
+    if (pwrite(memfd, buf, k, CAPTURE_HDR + (off_t)pos) < 0) return;
+    if (k < n && pwrite(memfd, buf + k, n - k, CAPTURE_HDR) < 0) return;
+}
+
+// Move exactly n bytes from pipe in to out (drained even when out fails).
+static void forward(int in, int out, size_t n, int *use_splice, int *out_ok, char *buf, size_t bufsz){
+    while (n > 0) {
+        ssize_t m;
+        if (*use_splice && *out_ok) {
+            m = splice(in, NULL, out, NULL, n, SPLICE_F_MOVE);
+            if (m > 0) { n -= (size_t)m; continue; }
+            if (m < 0 && errno == EINTR) continue;
+            if (m < 0 && errno == EINVAL) *use_splice = 0; // e.g. a terminal
+            else *out_ok = 0;
+            continue;
+        }
+        m = read(in, buf, n < bufsz ? n : bufsz);
+        if (m < 0 && errno == EINTR) continue;
+        if (m <= 0) return;
+        if (*out_ok && write_all(out, buf, (size_t)m) != 0) *out_ok = 0;
+        n -= (size_t)m;
+    }
+}
+
+void capture_pump(int in, int out, int memfd){
+    // Like tee -i: Ctrl-C ends the writers, and we still store what they wrote.
+    signal(SIGINT, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+    int use_splice = 1, out_ok = 1;
+    uint64_t total = 0;
+    char buf[65536];
+    int copy[2];
+    if (pipe(copy) == 0) {
+        for (;;) {
+            ssize_t n = tee(in, copy[1], sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break; // 0: no writers left
+            to_ring(copy[0], memfd, total, (size_t)n);
+            forward(in, out, (size_t)n, &use_splice, &out_ok, buf, sizeof(buf));
+            total += (uint64_t)n;
+        }
+    } else {
+        ssize_t n;
+        while ((n = read(in, buf, sizeof(buf))) != 0) {
+            if (n < 0) { if (errno == EINTR) continue; break; }
+            store(memfd, total, buf, (size_t)n);
+            total += (uint64_t)n;
+            if (out_ok && write_all(out, buf, (size_t)n) != 0) out_ok = 0;
+        }
+    }
+    if (pwrite(memfd, &total, sizeof(total), 0) < 0) return;
+}
+
+// Copy len bytes at off of the memfd to fd: sendfile where possible.
+static int replay_range(int fd, off_t off, size_t len){
+    static int use_sendfile = 1;
+    char buf[65536];
+    while (len > 0) {
+        ssize_t n = -1;
+        if (use_sendfile) {
+            n = sendfile(fd, last_fd, &off, len);
+            if (n < 0 && errno == EINVAL) { use_sendfile = 0; continue; }
+        } else {
+            n = pread(last_fd, buf, len < sizeof(buf) ? len : sizeof(buf), off);
+            if (n > 0 && write_all(fd, buf, (size_t)n) != 0) return -1;
+            if (n > 0) off += n;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return n < 0 ? -1 : 0;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void replay(void){
+    uint64_t total = 0;
+    if (last_fd < 0 || pread(last_fd, &total, sizeof(total), 0) != (ssize_t)sizeof(total)) return;
+    out_flush_all();
+    if (total <= CAPTURE_MAX) {
+        replay_range(STDOUT_FILENO, CAPTURE_HDR, (size_t)total);
+        return;
+    }
+    // Wrapped: the oldest kept byte sits right after the newest one.
+    size_t start = (size_t)(total % CAPTURE_MAX);
+    if (replay_range(STDOUT_FILENO, CAPTURE_HDR + (off_t)start, CAPTURE_MAX - start) == 0)
+        replay_range(STDOUT_FILENO, CAPTURE_HDR, start);
+}
+
+int run_last_argv(int argc, char **argv){
+    if (argc == 1) { replay(); return 0; }
+    if (argc == 2 && strcmp(argv[1], "on") == 0) { enabled = 1; return 0; }
+    if (argc == 2 && strcmp(argv[1], "off") == 0) { enabled = 0; return 0; }
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        if (last_fd >= 0) close(last_fd);
+        last_fd = -1;
+        return 0;
+    }
+    out_puts(out_stdout(), "last: Invalid Syntax!");
+    return 1;
+}
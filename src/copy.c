@@ -0,0 +1,391 @@
+// copy.c: cp -r -p as a builtin
+// -----------------------------
+// Implements: copy [-v] src... dst
+//   copy build/ /mnt/backup/build   -> copy a tree (dst is created)
+//   copy a.bin b.bin dir            -> into an existing directory
+//   copy -v big/ big2               -> also print files, bytes and time
+// Like cp -r -p: modes and timestamps are kept, symlinks are copied as
+// symlinks, a directory is never copied into itself and a file never onto
+// itself. Hard links are not preserved. Ctrl-C stops the copy between files.
+//
+// Walker: the same thread pool + shared LIFO stack as usage.c. A directory
+// task creates its copy, reads the source with getdents64() and queues one
+// task per entry, so large files and big directories are spread over all
+// threads. Everything is opened relative to the parent's descriptors
+// (openat), which stay open until their last child is done; when the last
+// reference to a destination directory goes, its mode and times are set
+// (earlier, creating the children would change them again).
+//
+// Each file tries, in order:
+// 1. ioctl(FICLONE): a reflink, no data copied at all (btrfs, xfs, ...);
+// 2. copy_file_range(): the kernel copies, possibly server-side (NFS) or
+//    offloaded to the device;
+// 3. read()/write() through a 1 MiB buffer.
+#define _GNU_SOURCE // copy_file_range(), statx(), O_NOFOLLOW, syscall()
+#include "copy.h"
+#include "dirs.h"
+#include "outbuf.h"
+#include "signals.h"
+#include "statcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h> // DT_DIR
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/fs.h> // FICLONE
+
+#define COPY_MAX_THREADS 16
+#define COPY_BUF (1 << 20)
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+typedef struct DirRef {
+    int fd;
+    int refs;           // the directory itself + its queued children
+    int apply;          // destination: set mode and times on last release
+    mode_t mode;
+    struct timespec times[2];
+} DirRef;
+
+typedef struct Task {
+    DirRef *src, *dst;  // NULL src: name is relative to the shell cwd
+    char *name;         // source entry
+    char *dname;        // destination entry, NULL = same as name
+    struct Task *next;
+} Task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    Task *stack;
+    int active;
+    int cancel;
+    struct stat *roots; // the destination roots: never copied into themselves
+    int nroots;
+    long files, dirs, errors;
+    unsigned long long bytes, cloned;
+    char first_error[300];
+} Walk;
+
+static void fail_msg(Walk *w, const char *name, const char *msg){
+    pthread_mutex_lock(&w->lock);
+    if (!w->errors++)
+        snprintf(w->first_error, sizeof(w->first_error), "copy: %s: %s", name, msg);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void fail(Walk *w, const char *name, int err){ fail_msg(w, name, strerror(err)); }
+
+static int same_file(const struct stat *a, const struct stat *b){
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino;
+}
+
+static int is_root(Walk *w, const struct stat *st){
+    int hit = 0;
+    pthread_mutex_lock(&w->lock);
+    for (int i = 0; i < w->nroots && !hit; i++) hit = same_file(&w->roots[i], st);
+    pthread_mutex_unlock(&w->lock);
+    return hit;
+}
+
+static void ref_release(Walk *w, DirRef *r){
+    if (!r) return;
+    pthread_mutex_lock(&w->lock);
+    int last = --r->refs == 0;
+    pthread_mutex_unlock(&w->lock);
+    if (!last) return;
+    if (r->apply) {
+        fchmod(r->fd, r->mode);
+        futimens(r->fd, r->times);
+    }
+    close(r->fd);
+    free(r);
+}
+
+static void push_task(Walk *w, DirRef *src, DirRef *dst, const char *name, const char *dname){
+    Task *t = calloc(1, sizeof(*t));
+    char *n = strdup(name), *dn = dname ? strdup(dname) : NULL;
+    if (!t || !n || (dname && !dn)) { free(t); free(n); free(dn); fail(w, name, ENOMEM); return; }
+    t->src = src;
+    t->dst = dst;
+    t->name = n;
+    t->dname = dn;
+    pthread_mutex_lock(&w->lock);
+    if (src) src->refs++;
+    if (dst) dst->refs++;
+    t->next = w->stack;
+    w->stack = t;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static int write_all(int fd, const char *p, size_t n){
+    while (n > 0) {
+        ssize_t r = write(fd, p, n);
+        if (r < 0) { if (errno == EINTR) continue; return -1; }
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+// Copy the data of in to out (size bytes); sets *cloned for a reflink.
+static int copy_data(int in, int out, off_t size, int *cloned){
+    *cloned = 0;
+    if (size > 0 && ioctl(out, FICLONE, in) == 0) { *cloned = 1; return 0; }
+    off_t done = 0;
+    while (done < size) {
+        ssize_t n = copy_file_range(in, NULL, out, NULL, (size_t)(size - done), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break; // unsupported here (EXDEV, EINVAL, ...) or file shrank
+        done += n;
+    }
+    if (done >= size) return 0;
+    // Fallback (also finishes a partial copy_file_range and files that grew).
+    char *buf = malloc(COPY_BUF);
+    if (!buf) return -1;
+    int rc = 0;
+    if (lseek(in, done, SEEK_SET) < 0 || lseek(out, done, SEEK_SET) < 0) rc = -1;
+    while (rc == 0) {
+        ssize_t n = read(in, buf, COPY_BUF);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) rc = -1;
+        if (n <= 0) break;
+        if (write_all(out, buf, (size_t)n) != 0) rc = -1;
+    }
+    free(buf);
+    return rc;
+}
+
+static void copy_file(Walk *w, Task *t, int sbase, const char *dname, const struct stat *st){
+    int in = openat(sbase, t->name, O_RDONLY | O_CLOEXEC | (t->src ? O_NOFOLLOW : 0));
+    if (in < 0) { fail(w, t->name, errno); return; }
+    // Truncate only after making sure the destination is not the source.
+    int out = openat(t->dst->fd, dname, O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+    if (out < 0) { fail(w, dname, errno); close(in); return; }
+    struct stat out_st;
+    if (fstat(out, &out_st) != 0) { fail(w, dname, errno); close(out); close(in); return; }
+    if (same_file(&out_st, st)) {
+        fail_msg(w, t->name, "source and destination are the same file");
+        close(out); close(in);
+        return;
+    }
+    if (ftruncate(out, 0) != 0) { fail(w, dname, errno); close(out); close(in); return; }
+    int cloned = 0;
+    if (copy_data(in, out, st->st_size, &cloned) != 0) fail(w, t->name, errno);
+    struct timespec times[2] = { st->st_atim, st->st_mtim };
+    fchmod(out, st->st_mode & 07777);
+    futimens(out, times);
+    if (close(out) != 0) fail(w, dname, errno);
+    close(in);
+    pthread_mutex_lock(&w->lock);
+    w->files++;
+    w->bytes += (unsigned long long)st->st_size;
+    w->cloned += cloned ? (unsigned long long)st->st_size : 0;
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void copy_dir(Walk *w, Task *t, int sbase, const char *dname, const struct stat *st){
+    if (is_root(w, st)) return; // our own copy
+    if (mkdirat(t->dst->fd, dname, 0700) != 0 && errno != EEXIST) { fail(w, dname, errno); return; }
+    int sfd = openat(sbase, t->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (t->src ? O_NOFOLLOW : 0));
+    int dfd = openat(t->dst->fd, dname, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+    DirRef *s = malloc(sizeof(*s)), *d = malloc(sizeof(*d));
+    if (sfd < 0 || dfd < 0 || !s || !d) {
+        fail(w, sfd < 0 ? t->name : dname, errno ? errno : ENOMEM);
+        if (sfd >= 0) close(sfd);
+        if (dfd >= 0) close(dfd);
+        free(s); free(d);
+        return;
+    }
+    if (!t->src) { // a root: remember it so no walk ever enters it
+        struct stat dst_st;
+        if (fstat(dfd, &dst_st) == 0) {
+            if (same_file(&dst_st, st)) {
+                fail_msg(w, t->name, "source and destination are the same directory");
+                close(sfd); close(dfd); free(s); free(d);
+                return;
+            }
+            pthread_mutex_lock(&w->lock);
+            w->roots[w->nroots++] = dst_st;
+            pthread_mutex_unlock(&w->lock);
+        }
+    }
+    *s = (DirRef){ .fd = sfd, .refs = 1 };
+    *d = (DirRef){ .fd = dfd, .refs = 1, .apply = 1, .mode = st->st_mode & 07777,
+                   .times = { st->st_atim, st->st_mtim } };
+    char buf[32768];
+    for (;;) {
+        long n = syscall(SYS_getdents64, sfd, buf, sizeof(buf));
+        if (n < 0) fail(w, t->name, errno);
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            struct linux_dirent64 *e = (struct linux_dirent64 *)(buf + off);
+            off += e->d_reclen;
+            const char *name = e->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            push_task(w, s, d, name, NULL);
+        }
+    }
+    pthread_mutex_lock(&w->lock);
+    w->dirs++;
+    pthread_mutex_unlock(&w->lock);
+    ref_release(w, s);
+    ref_release(w, d);
+}
+
+static void process(Walk *w, Task *t){
+    int sbase = t->src ? t->src->fd : dirs_cwd_fd();
+    const char *dname = t->dname ? t->dname : t->name;
+    struct stat st;
+    // The roots may be symlinks; nothing below them is followed.
+    if (fstatat(sbase, t->name, &st, t->src ? AT_SYMLINK_NOFOLLOW : 0) != 0) { fail(w, t->name, errno); return; }
+    if (S_ISDIR(st.st_mode)) {
+        copy_dir(w, t, sbase, dname, &st);
+    } else if (S_ISREG(st.st_mode)) {
+        copy_file(w, t, sbase, dname, &st);
+    } else if (S_ISLNK(st.st_mode)) {
+        char target[4096];
+        ssize_t n = readlinkat(sbase, t->name, target, sizeof(target) - 1);
+        if (n < 0) { fail(w, t->name, errno); return; }
+        target[n] = '\0';
+        if (symlinkat(target, t->dst->fd, dname) != 0) { fail(w, dname, errno); return; }
+        struct timespec times[2] = { st.st_atim, st.st_mtim };
+        utimensat(t->dst->fd, dname, times, AT_SYMLINK_NOFOLLOW);
+    } else if (S_ISFIFO(st.st_mode)) {
+        if (mkfifoat(t->dst->fd, dname, st.st_mode & 07777) != 0) fail(w, dname, errno);
+    } else {
+        fail(w, t->name, ENOTSUP); // devices and sockets
+    }
+}
+
+static void *worker(void *arg){
+    Walk *w = arg;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (!w->stack && w->active > 0) pthread_cond_wait(&w->cond, &w->lock);
+        if (!w->stack) break;
+        Task *t = w->stack;
+        w->stack = t->next;
+        if (!w->cancel && signals_take_interrupt()) w->cancel = 1;
+        int skip = w->cancel;
+        w->active++;
+        pthread_mutex_unlock(&w->lock);
+        if (!skip) process(w, t);
+        ref_release(w, t->src);
+        ref_release(w, t->dst);
+        free(t->name);
+        free(t->dname);
+        free(t);
+        pthread_mutex_lock(&w->lock);
+        w->active--;
+        if (!w->stack && w->active == 0) pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+static int copy_threads(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    // Mostly waiting on storage: keep more requests in flight than CPUs.
+    n = n > 0 ? n * 2 : 2;
+    if (n < 2) n = 2;
+    if (n > COPY_MAX_THREADS) n = COPY_MAX_THREADS;
+    return (int)n;
+}
+
+static const char *base_name(const char *path, char *buf, size_t n){
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') len--;
+    size_t start = len;
+    while (start > 0 && path[start - 1] != '/') start--;
+    snprintf(buf, n, "%.*s", (int)(len - start), path + start);
+    return buf;
+}
+
+int run_copy_argv(int argc, char **argv){
+    int verbose = 0, first = 1;
+    if (first < argc && strcmp(argv[first], "-v") == 0) { verbose = 1; first++; }
+    if (argc - first < 2) { out_puts(out_stdout(), "copy: Invalid Syntax!"); return 1; }
+    const char *dst = argv[argc - 1];
+    int nsrc = argc - first - 1;
+
+    // Into dst/ when it is an existing directory, else dst is the new name.
+    char dir[4096], name[1024];
+    struct stat st;
+    int into = fstatat(dirs_cwd_fd(), dst, &st, 0) == 0 && S_ISDIR(st.st_mode);
+    if (!into && nsrc > 1) { out_puts(out_stdout(), "No such directory!"); return 1; }
+    if (into) snprintf(dir, sizeof(dir), "%s", dst);
+    else {
+        const char *slash = strrchr(dst, '/');
+        if (!slash) snprintf(dir, sizeof(dir), ".");
+        else snprintf(dir, sizeof(dir), "%.*s", (int)(slash - dst) + (slash == dst), dst);
+        base_name(dst, name, sizeof(name));
+    }
+    int dfd = openat(dirs_cwd_fd(), dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) { out_puts(out_stdout(), "No such directory!"); return 1; }
+    DirRef *root = malloc(sizeof(*root));
+    if (!root) { close(dfd); return 1; }
+    *root = (DirRef){ .fd = dfd, .refs = 1 };
+
+    Walk w;
+    memset(&w, 0, sizeof(w));
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+    w.roots = calloc((size_t)nsrc, sizeof(*w.roots));
+    if (!w.roots) {
+        ref_release(&w, root);
+        pthread_cond_destroy(&w.cond);
+        pthread_mutex_destroy(&w.lock);
+        return 1;
+    }
+    signals_take_interrupt(); // forget a Ctrl-C typed before this command
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = first; i < argc - 1; i++) {
+        char bn[1024];
+        push_task(&w, NULL, root, argv[i], into ? base_name(argv[i], bn, sizeof(bn)) : name);
+    }
+    ref_release(&w, root);
+
+    pthread_t tids[COPY_MAX_THREADS];
+    int nthreads = copy_threads() - 1, started = 0; // this thread works too
+    for (int i = 0; i < nthreads; i++)
+        if (pthread_create(&tids[started], NULL, worker, &w) == 0) started++;
+    worker(&w);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&w.cond);
+    pthread_mutex_destroy(&w.lock);
+    free(w.roots);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    statcache_invalidate();
+
+    if (w.errors) {
+        out_printf(out_stderr(), "%s", w.first_error);
+        if (w.errors > 1) out_printf(out_stderr(), " (and %ld more errors)", w.errors - 1);
+        out_putc(out_stderr(), '\n');
+        out_flush(out_stderr());
+    }
+    if (w.cancel) { out_puts(out_stderr(), "copy: interrupted"); out_flush(out_stderr()); }
+    if (verbose) {
+        double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+        out_printf(out_stdout(), "%ld files, %ld directories, %llu bytes (%llu cloned) in %.2fs\n",
+                   w.files, w.dirs, w.bytes, w.cloned, secs);
+        out_flush(out_stdout());
+    }
+    return w.errors || w.cancel ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+// cut.c: select bytes or fields of each line
+// ------------------------------------------
+// Implements: cut -b list [file...]  |  cut -f list [-d delim] [-s] [file...]
+//   cut -d: -f1,6 /etc/passwd   -> user names and home directories
+//   cut -f2- data.tsv           -> drop the first tab-separated column
+//   cut -b1-8 log               -> first eight bytes of each line
+// A list is comma-separated positions and ranges counted from 1: "3",
+// "2-4", "-3" (1-3), "5-" (5 to the end). -c is accepted as a synonym for
+// -b (bytes only, no multibyte locales). The field delimiter defaults to
+// tab; lines without it are printed whole unless -s is given. Without files
+// (or with "-") stdin is read.
+//
+// Input is read in 128 KiB blocks and cut line by line inside the block;
+// lines and delimiters are located with memchr(), which the C library
+// vectorizes, and scanning stops at the last selected field so the rest of
+// a wide line is skipped in one jump to its newline.
+#include "cut.h"
+#include "dirs.h"
+#include "lineread.h"
+#include "outbuf.h"
+#include "signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define CUT_BLOCK (128 * 1024)
+#define CUT_MAX_RANGES 64
+
+typedef struct { size_t lo, hi; } Range; // 1-based, inclusive; hi SIZE_MAX = to the end
+
+typedef struct {
+    Range r[CUT_MAX_RANGES];
+    int n;
+    int fields;       // -f (else -b)
+    char delim;
+    int only_delimited;
+} Cut;
+
+static int parse_pos(const char **sp, size_t *out){
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(*sp, &end, 10);
+    if (end == *sp || errno || v == 0) return -1;
+    *out = (size_t)v;
+    *sp = end;
+    return 0;
+}
+
+static int cmp_range(const void *a, const void *b){
+    const Range *x = a, *y = b;
+    return x->lo < y->lo ? -1 : x->lo > y->lo;
+}
+
+// Parse "1,3-5,7-" into sorted, merged ranges.
+static int parse_list(const char *s, Cut *c){
+    c->n = 0;
+    for (;;) {
+        Range r = { 1, SIZE_MAX };
+        if (*s != '-' && parse_pos(&s, &r.lo) != 0) return -1;
+        if (*s == '-') {
+            s++;
+            if (*s && *s != ',' && parse_pos(&s, &r.hi) != 0) return -1;
+            if (r.hi < r.lo) return -1;
+        } else {
+            r.hi = r.lo;
+        }
+        if (c->n == CUT_MAX_RANGES) return -1;
+        c->r[c->n++] = r;
+        if (*s == '\0') break;
+        if (*s++ != ',') return -1;
+    }
+    qsort(c->r, (size_t)c->n, sizeof(Range), cmp_range);
+    int m = 0;
+    for (int k = 1; k < c->n; k++) {
+        if (c->r[k].lo <= c->r[m].hi || c->r[k].lo - 1 == c->r[m].hi) {
+            if (c->r[k].hi > c->r[m].hi) c->r[m].hi = c->r[k].hi;
+        } else {
+            c->r[++m] = c->r[k];
+        }
+    }
+    c->n = m + 1;
+    return 0;
+}
+
+static void cut_bytes(const Cut *c, OutBuf *out, const char *line, size_t len){
+    for (int k = 0; k < c->n && c->r[k].lo <= len; k++) {
+        size_t hi = c->r[k].hi < len ? c->r[k].hi : len;
+        out_write(out, line + c->r[k].lo - 1, hi - c->r[k].lo + 1);
+    }
+    out_putc(out, '\n');
+}
+
+static void cut_fields(const Cut *c, OutBuf *out, const char *line, size_t len){
+    const char *s = line, *e = line + len;
+    const char *d = memchr(s, c->delim, len);
+    if (!d) {
+        if (!c->only_delimited) { out_write(out, line, len); out_putc(out, '\n'); }
+        return;
+    }
+    size_t f = 1;
+    int k = 0, printed = 0;
+    for (;;) {
+        while (k < c->n && c->r[k].hi < f) k++;
+        if (k == c->n) break; // past the last selected field
+        const char *fe = d ? d : e;
+        if (f >= c->r[k].lo) {
+            if (printed) out_putc(out, c->delim);
+            out_write(out, s, (size_t)(fe - s));
+            printed = 1;
+        }
+        if (!d) break;
+        s = d + 1;
+        f++;
+        d = memchr(s, c->delim, (size_t)(e - s));
+    }
+    out_putc(out, '\n');
+}
+
+// Cut every line of fd; returns 0, or -1 on a read error or Ctrl-C.
+static int cut_fd(const Cut *c, int fd, char **buf, size_t *cap){
+    OutBuf *out = out_stdout();
+    size_t have = 0; // bytes of an unfinished line kept at the front of *buf
+    for (;;) {
+        if (*cap - have < CUT_BLOCK / 2) { // a long line: make room
+            char *nb = realloc(*buf, *cap * 2);
+            if (!nb) return -1;
+            *buf = nb;
+            *cap *= 2;
+        }
+        ssize_t n = lr_read_block(fd, *buf + have, *cap - have);
+        if (n == -2 || signals_take_interrupt()) return -1;
+        if (n == 0) break;
+        const char *p = *buf, *end = *buf + have + n, *nl;
+        while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+            if (c->fields) cut_fields(c, out, p, (size_t)(nl - p));
+            else cut_bytes(c, out, p, (size_t)(nl - p));
+            p = nl + 1;
+        }
+        have = (size_t)(end - p);
+        memmove(*buf, p, have);
+    }
+    if (have) { // last line without a newline
+        if (c->fields) cut_fields(c, out, *buf, have);
+        else cut_bytes(c, out, *buf, have);
+    }
+    return 0;
+}
+
+int run_cut_argv(int argc, char **argv){
+    Cut c = { .n = 0, .fields = -1, .delim = '\t', .only_delimited = 0 };
+    const char *list = NULL, *delim = NULL;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        char opt = argv[i][1];
+        if (opt == 's' && argv[i][2] == '\0') { c.only_delimited = 1; continue; }
+        if (opt != 'b' && opt != 'c' && opt != 'f' && opt != 'd') break;
+        // The value may be attached (-f1,2) or the next argument (-f 1,2).
+        const char *val = argv[i][2] ? argv[i] + 2 : i + 1 < argc ? argv[++i] : NULL;
+        if (!val) { list = NULL; c.fields = -2; break; }
+        if (opt == 'd') { delim = val; continue; }
+        if (c.fields != -1) { c.fields = -2; break; } // only one list
+        c.fields = opt == 'f';
+        list = val;
+    }
+    if (c.fields < 0 || !list || parse_list(list, &c) != 0
+        || (delim && (!c.fields || strlen(delim) != 1)) || (c.only_delimited && !c.fields)) {
+        out_puts(out_stdout(), "cut: Invalid Syntax!");
+        return 1;
+    }
+    if (delim) c.delim = delim[0];
+
+    out_flush_all(); // a prompt printed just before must be visible
+    size_t cap = CUT_BLOCK;
+    char *buf = malloc(cap);
+    if (!buf) return 1;
+    signals_take_interrupt(); // forget a Ctrl-C typed before this command
+    static char *dash[] = { "-", NULL };
+    char **files = i < argc ? &argv[i] : dash;
+    int nfiles = i < argc ? argc - i : 1, rc = 0;
+    for (int f = 0; f < nfiles; f++) {
+        int fd = strcmp(files[f], "-") == 0 ? STDIN_FILENO
+                                            : openat(dirs_cwd_fd(), files[f], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            out_printf(out_stderr(), "cut: %s: %s\n", files[f], strerror(errno));
+            rc = 1;
+            continue;
+        }
+        int r = cut_fd(&c, fd, &buf, &cap);
+        if (fd != STDIN_FILENO) close(fd);
+        if (r != 0) { rc = 1; break; }
+    }
+    free(buf);
+    out_flush(out_stdout());
+    out_flush(out_stderr());
+    return rc;
+}
@@ -0,0 +1,90 @@
+// dirs.c: directory descriptors for path resolution
+// -------------------------------------------------
+// Builtins used to pass path strings around (getcwd() + chdir(prev_cwd),
+// opendir(path), open(redirect_target)), so the kernel re-walked every path
+// component each time, and 'hop -' broke as soon as the remembered directory
+// was renamed.
+//
+// Instead we keep three O_PATH descriptors:
+//   cwd_fd  - the shell's current directory
+//   home_fd - the shell home ('~')
+//   prev_fd - the previous directory ('hop -', 'reveal -')
+// Changing directory is openat(base, target) + fchdir(); listing is
+// openat() + fdopendir(). O_PATH descriptors are cheap: they only pin the
+// directory, they don't open it for reading.
+#define _GNU_SOURCE // O_PATH
+#include "dirs.h"
+#include "statcache.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <linux/limits.h> // for PATH_MAX
+
+#define PATH_FLAGS (O_PATH | O_DIRECTORY | O_CLOEXEC)
+
+static int cwd_fd = -1;
+static int home_fd = -1;
+static int prev_fd = -1;
+
+// Cached stats are keyed by descriptor number, and the number may be
+// reused for another directory: forget them whenever a descriptor changes.
+static void replace_fd(int *slot, int fd){
+    if (*slot >= 0) close(*slot);
+    *slot = fd;
+    statcache_invalidate();
+}
+
+void dirs_init(void){
+    replace_fd(&cwd_fd, open(".", PATH_FLAGS));
+}
+
+void dirs_sync_cwd(void){ dirs_init(); }
+
+int dirs_cwd_fd(void){ return cwd_fd >= 0 ? cwd_fd : AT_FDCWD; }
+int dirs_home_fd(void){ return home_fd; }
+int dirs_prev_fd(void){ return prev_fd; }
+
+void dirs_set_home(const char *path){
+    if (!path) return;
+    replace_fd(&home_fd, open(path, PATH_FLAGS));
+}
+
+int dirs_chdir_at(int base, const char *path, int record_prev){
+    if (base == -1) return -1; // e.g. home unknown
+    int fd = openat(base, path, PATH_FLAGS);
+    if (fd < 0) return -1;
+    if (fchdir(fd) != 0) { close(fd); return -1; }
+    if (record_prev && cwd_fd >= 0) { replace_fd(&prev_fd, cwd_fd); cwd_fd = -1; }
+    replace_fd(&cwd_fd, fd);
+    return 0;
+}
+
+int dirs_swap_prev(void){
+    if (prev_fd < 0 || fchdir(prev_fd) != 0) return -1;
+    int old = cwd_fd;
+    cwd_fd = prev_fd;
+    prev_fd = old;
+    statcache_invalidate(); // relative names now resolve elsewhere
+    return 0;
+}
+
+void dirs_set_prev_path(const char *path){
+    replace_fd(&prev_fd, (path && *path) ? open(path, PATH_FLAGS) : -1);
+}
+
+const char *dirs_prev_path(void){
+    static char buf[PATH_MAX];
+    if (prev_fd < 0) return NULL;
+    char link[64];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", prev_fd);
+    ssize_t n = readlink(link, buf, sizeof(buf) - 1);
+    if (n <= 0) return NULL;
+    buf[n] = '\0';
+    return buf;
+}
+
+int dirs_open_dir(int base, const char *path){
+    if (base == -1) return -1;
+    return openat(base, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
@@ -5,9 +5,15 @@
 // job. To keep things digestible for beginners we:
 // - parse the first command-group ourselves (very small tokenizer)
 // - implement simple pipelines with '|'
-// - support basic redirections: <, >, >> (both attached and spaced forms)
+// - expand {a,b} and {1..N} braces in words (expand.c)
+// - support basic redirections: <, >, >> (both attached and spaced forms);
+//   targets are opened relative to the shell's cwd descriptor (dirs.c)
 // - run known builtins without exec (they can also run in child when piped)
 // - assign a process group to pipelines and hand over the terminal to them
+// - optionally move a long-running foreground pipeline to the background
+//   without stopping it ('setopt autobg', setopt.c)
+// - run consecutive record builtins (reveal | where ... | sortby ...) as one
+//   stage that passes typed records in memory (records.c)
 //
 // Reading guidance:
 // 1) Data structures at the top (SimpleCmd, Pipeline, Redir)
@@ -28,11 +34,20 @@
 #include <termios.h>
 #include <errno.h>
 #include "signals.h"
+#include "outbuf.h"
+#include "dirs.h"
+#include "prewarm.h"
+#include "expand.h"
+#include "vars.h"
+#include "capture.h"
+#include "statcache.h"
+#include "script.h"
+#include "setopt.h"
+#include "records.h"
 #include <unistd.h>
 #include <time.h>
 
 #define MAX_CMDS 16   // up to 16 commands in a single pipeline
-#define MAX_ARGS 64   // up to 64 arguments per command (including argv[0])
 #define MAX_REDIRS 16 // up to 16 redirections per command
 
 typedef enum { R_IN = 0, R_OUT_TRUNC = 1, R_OUT_APPEND = 2 } RedirType;
@@ -43,9 +58,12 @@ typedef struct {
 } Redir;
 
 typedef struct {
-    char *argv[MAX_ARGS]; // NULL-terminated
+    char **argv;          // NULL-terminated, grows as words are added
+    int argc, argv_cap;
+    size_t arg_bytes;     // total size of the words, checked against ARG_MAX
     Redir redirs[MAX_REDIRS];
     int redir_count;
+    int records;          // joined record stages, "|" words between them (records.c)
 } SimpleCmd;
 
 typedef struct {
@@ -86,16 +104,71 @@ static char* read_name(const char **pp){
     return tok;
 }
 
+// Append one word (len bytes) to cmd->argv. Returns non-zero once the words
+// would no longer fit into ARG_MAX.
+static long arg_max(void){
+    static long max = 0;
+    if (!max) { max = sysconf(_SC_ARG_MAX); if (max <= 0) max = 131072; }
+    return max;
+}
+
+static int add_arg_n(const char *word, size_t n, void *ud){
+    SimpleCmd *cmd = ud;
+    size_t len = n + 1;
+    if (cmd->arg_bytes + len + (size_t)(cmd->argc + 2) * sizeof(char *) > (size_t)arg_max()) {
+        fprintf(stderr, "too many arguments (ARG_MAX is %ld bytes)\n", arg_max());
+        return 1;
+    }
+    if (cmd->argc + 2 > cmd->argv_cap) {
+        int ncap = cmd->argv_cap ? cmd->argv_cap * 2 : 16;
+        char **na = realloc(cmd->argv, (size_t)ncap * sizeof(char *));
+        if (!na) return 1;
+        cmd->argv = na;
+        cmd->argv_cap = ncap;
+    }
+    char *dup = dup_range(word, n);
+    if (!dup) return 1;
+    cmd->argv[cmd->argc++] = dup;
+    cmd->argv[cmd->argc] = NULL;
+    cmd->arg_bytes += len;
+    return 0;
+}
+
+// Brace expansion callback.
+static int add_arg(const char *word, void *ud){
+    return add_arg_n(word, strlen(word), ud);
+}
+
+// Brace expansion callback: $NAME expansion (vars.c) of one word. A bare
+// ${NAME[@]} becomes one word per array element.
+static int add_expanded(const char *word, void *ud){
+    int rc = vars_expand_each(word, add_arg_n, ud);
+    if (rc >= 0) return rc;
+    char *expanded = vars_expand(word);
+    rc = add_arg(expanded ? expanded : word, ud);
+    free(expanded);
+    return rc;
+}
+
+// Add a token to argv after brace expansion ({a,b} and {1..N}; expand.c)
+// and then $NAME expansion of each resulting word, in that order like bash:
+// braces come from the literal text, never from a variable's value. Takes
+// ownership of tok. Returns 0 if the command got too long.
+static int add_word(SimpleCmd *cmd, char *tok){
+    int rc = expand_braces(tok, add_expanded, cmd);
+    free(tok);
+    return rc == 0;
+}
+
 // Parse one command segment (no pipes inside): argv + optional redirections
 static int parse_segment(const char *seg, SimpleCmd *cmd){
     memset(cmd, 0, sizeof(*cmd));
-    int argc = 0;
     const char *p = seg;
     p = skip_ws(p);
     // First token must be the program name
     char *tok = read_name(&p);
     if (!tok) return 0;
-    cmd->argv[argc++] = tok;
+    if (!add_word(cmd, tok)) return 0;
 
     // Other tokens: args or redirections (<, >, >>) in any order
     for (;;) {
@@ -135,18 +208,60 @@ static int parse_segment(const char *seg, SimpleCmd *cmd){
         // Normal argument
         tok = read_name(&p);
         if (!tok) break;
-        if (argc < MAX_ARGS-1) {
-            cmd->argv[argc++] = tok;
-        } else {
-            fprintf(stderr, "too many arguments (max %d)\n", MAX_ARGS-1);
-            free(tok);
-            return 0;
-        }
+        if (!add_word(cmd, tok)) return 0;
     }
-    cmd->argv[argc] = NULL;
+    // Every word expanded to nothing (e.g. an empty ${arr[@]}): no command.
+    return cmd->argc > 0;
+}
+
+static void free_pipeline(Pipeline *pl);
+
+// Can stage b take records from stage a directly? Only when nothing is
+// redirected in between.
+static int joins_records(const SimpleCmd *a, const SimpleCmd *b){
+    if (!records_joinable(a->argv[0]) || !records_is_filter(b->argv[0])) return 0;
+    if (a->redir_count + b->redir_count > MAX_REDIRS) return 0;
+    for (int r = 0; r < a->redir_count; r++) if (a->redirs[r].type != R_IN) return 0;
+    for (int r = 0; r < b->redir_count; r++) if (b->redirs[r].type == R_IN) return 0;
     return 1;
 }
 
+// Merge each run of record stages (reveal | where ... | sortby ...) into
+// its first stage: one builtin call then passes typed records along in
+// memory instead of printing and re-parsing text between processes.
+static void join_record_stages(Pipeline *pl){
+    int out = 0;
+    for (int i = 0; i < pl->count; ) {
+        SimpleCmd *head = &pl->cmds[i];
+        int j = i + 1;
+        for (; j < pl->count && joins_records(head, &pl->cmds[j]); j++) {
+            SimpleCmd *next = &pl->cmds[j];
+            // Too long together ("|" plus next's words): the rest stay separate stages.
+            if (head->arg_bytes + 2 + next->arg_bytes +
+                (size_t)(head->argc + 1 + next->argc + 1) * sizeof(char *) > (size_t)arg_max()) break;
+            int argc0 = head->argc;
+            size_t bytes0 = head->arg_bytes;
+            int ok = !add_arg("|", head);
+            for (int k = 0; ok && k < next->argc; k++) ok = !add_arg(next->argv[k], head);
+            if (!ok) { // out of memory: drop the partial words
+                while (head->argc > argc0) free(head->argv[--head->argc]);
+                head->argv[head->argc] = NULL;
+                head->arg_bytes = bytes0;
+                break;
+            }
+            for (int r = 0; r < next->redir_count; r++) head->redirs[head->redir_count++] = next->redirs[r];
+            for (int k = 0; k < next->argc; k++) free(next->argv[k]);
+            free(next->argv);
+            memset(next, 0, sizeof(*next));
+            head->records = 1;
+        }
+        if (out != i) { pl->cmds[out] = *head; memset(head, 0, sizeof(*head)); }
+        out++;
+        for (i++; i < j; i++) { } // stages merged into head
+    }
+    pl->count = out;
+}
+
 // Parse a pipeline: split by '|' and parse each segment
 static int parse_pipeline(const char *first, Pipeline *out){
     memset(out, 0, sizeof(*out));
@@ -163,7 +278,12 @@ static int parse_pipeline(const char *first, Pipeline *out){
         if (out->count >= MAX_CMDS) { fprintf(stderr, "too many pipeline stages (max %d)\n", MAX_CMDS); return 0; }
         char *seg = dup_range(seg_start, (size_t)(seg_end - seg_start));
         if (!seg) return 0;
-        if (!parse_segment(seg, &out->cmds[out->count])) { free(seg); return 0; }
+        if (!parse_segment(seg, &out->cmds[out->count])) {
+            free(seg);
+            out->count++; // release the partially parsed command too
+            free_pipeline(out);
+            return 0;
+        }
         free(seg);
         out->count++;
         if (*p == '|') {
@@ -175,13 +295,15 @@ static int parse_pipeline(const char *first, Pipeline *out){
         }
         // continue loop
     }
+    if (out->count > 1) join_record_stages(out);
     return (out->count > 0);
 }
 
 static void free_pipeline(Pipeline *pl){
     for (int i=0;i<pl->count;i++) {
         SimpleCmd *c = &pl->cmds[i];
-        for (int j=0; c->argv[j]; j++) free(c->argv[j]);
+        for (int j=0; j<c->argc; j++) free(c->argv[j]);
+        free(c->argv);
         for (int r=0; r<c->redir_count; r++) {
             free(c->redirs[r].path);
         }
@@ -193,21 +315,62 @@ static void free_pipeline(Pipeline *pl){
 // Forward declare builtin helper used inside run_pipeline (defined later)
 static int run_builtin(SimpleCmd *c);
 
+// Would this stage start this shell binary on a command file? Then the
+// child interprets it directly instead of exec'ing (see script.c).
+static int runs_self(const char *exe, char **argv){
+    return script_is_self(exe ? exe : strchr(argv[0], '/') ? argv[0] : NULL, argv);
+}
+
 static int run_pipeline(Pipeline *pl){
     int n = pl->count;
     if (n <= 0) return 1;
-    pid_t pids[MAX_CMDS];
+    pid_t pids[MAX_CMDS + 1]; // + capture helper
     for (int i=0;i<n;i++) pids[i] = -1;
     pid_t pgid = -1;
 
     int prev_read = -1;
     int status_code = 0;
 
+    // With `last on`, output of the last stage that would reach the terminal
+    // goes through a capture pipe instead (capture.c).
+    int cap_fd = -1, cap_pipe[2] = {-1,-1};
+    int last_redirected = 0;
+    for (int ri = 0; ri < pl->cmds[n-1].redir_count; ri++)
+        if (pl->cmds[n-1].redirs[ri].type != R_IN) last_redirected = 1;
+    if (!last_redirected && (cap_fd = capture_start()) >= 0 && pipe(cap_pipe) < 0) {
+        close(cap_fd); cap_fd = -1;
+    }
+    // The capture helper is forked before any stage, so the last stage never
+    // writes into a pipe nobody reads. It joins the job's process group like
+    // one more stage once the first stage has made that group.
+    pid_t cap_pid = -1;
+    if (cap_pipe[0] != -1) {
+        out_flush_all();
+        cap_pid = fork();
+        if (cap_pid == 0) {
+            close(cap_pipe[1]);
+            signals_reset_for_child();
+            capture_pump(cap_pipe[0], STDOUT_FILENO, cap_fd);
+            _exit(0);
+        }
+        if (cap_pid < 0) { // run uncaptured; `last` keeps the previous output
+            perror("fork");
+            close(cap_pipe[0]); close(cap_pipe[1]); close(cap_fd);
+            cap_pipe[0] = cap_pipe[1] = cap_fd = -1;
+        }
+    }
+
     for (int i=0;i<n;i++) {
         int pipefd[2] = {-1,-1};
         if (i < n-1) {
             if (pipe(pipefd) < 0) { perror("pipe"); status_code = 1; break; }
+        } else if (cap_pipe[1] != -1) {
+            pipefd[1] = dup(cap_pipe[1]); // closed below like a pipe end
         }
+        // Resolve in the parent so the PATH lookup is cached for next time.
+        const char *exe = executor_is_builtin(pl->cmds[i].argv[0]) ? NULL : prewarm_resolve(pl->cmds[i].argv[0]);
+        int self = !executor_is_builtin(pl->cmds[i].argv[0]) && runs_self(exe, pl->cmds[i].argv);
+        out_flush_all(); // nothing buffered may be duplicated into the child
         pid_t pid = fork();
         if (pid < 0) { perror("fork"); status_code = 1; break; }
         if (pid == 0) {
@@ -231,12 +394,12 @@ static int run_pipeline(Pipeline *pl){
             for (int ri = 0; ri < c->redir_count; ri++) {
                 Redir *r = &c->redirs[ri];
                 if (r->type == R_IN) {
-                    int fd = open(r->path, O_RDONLY);
+                    int fd = openat(dirs_cwd_fd(), r->path, O_RDONLY);
                     if (fd < 0) { fprintf(stderr, "No such file or directory\n"); _exit(1); }
                     dup2(fd, STDIN_FILENO); close(fd);
                 } else {
                     int flags = O_WRONLY | O_CREAT | ((r->type==R_OUT_APPEND) ? O_APPEND : O_TRUNC);
-                    int fd = open(r->path, flags, 0644);
+                    int fd = openat(dirs_cwd_fd(), r->path, flags, 0644);
                     if (fd < 0) { fputs("Unable to create file for writing\n", stderr); _exit(1); }
                     dup2(fd, STDOUT_FILENO); close(fd);
                 }
@@ -245,11 +408,15 @@ static int run_pipeline(Pipeline *pl){
             if (prev_read != -1) close(prev_read);
             if (pipefd[0] != -1) close(pipefd[0]);
             if (pipefd[1] != -1) close(pipefd[1]);
+            if (cap_pipe[0] != -1) { close(cap_pipe[0]); close(cap_pipe[1]); }
             // Builtin? Run directly then exit the child with its return code.
             int b = run_builtin(c);
             if (b != -1) {
+                out_flush_all(); // _exit() would drop buffered builtin output
                 _exit(b);
             }
+            if (self) script_run_inline(c->argv);
+            if (exe) execv(exe, c->argv);
             execvp(c->argv[0], c->argv);
             // Standardize unknown command error message for tests
             fputs("Command not found!\n", stderr);
@@ -262,6 +429,7 @@ static int run_pipeline(Pipeline *pl){
         if (setpgid(pid, pgid) < 0 && errno != EACCES && errno != ESRCH) {
             // ignore errors where child already exec'd
         }
+        if (i == 0 && cap_pid > 0) setpgid(cap_pid, pgid);
         if (prev_read != -1) close(prev_read);
         if (pipefd[1] != -1) close(pipefd[1]);
         prev_read = pipefd[0];
@@ -269,41 +437,79 @@ static int run_pipeline(Pipeline *pl){
 
     if (prev_read != -1) close(prev_read);
 
+    // The capture helper is waited for like one more stage.
+    int nprocs = n;
+    if (cap_pid > 0) {
+        close(cap_pipe[0]); close(cap_pipe[1]);
+        if (pgid != -1) {
+            pids[nprocs++] = cap_pid;
+            capture_finish(cap_fd);
+        } else { // no stage started: nothing to keep
+            while (waitpid(cap_pid, NULL, 0) < 0 && errno == EINTR) { }
+            close(cap_fd);
+        }
+    }
+
     // Record foreground job and give the terminal to its process group.
-    jobs_set_foreground(pgid, pids, n, pl->cmds[0].argv[0] ? pl->cmds[0].argv[0] : "?");
+    jobs_set_foreground(pgid, pids, nprocs, pl->cmds[0].argv[0] ? pl->cmds[0].argv[0] : "?");
     // store name locally for message after move
     strncpy(last_fg_name, pl->cmds[0].argv[0]?pl->cmds[0].argv[0]:"?", sizeof(last_fg_name)-1); last_fg_name[sizeof(last_fg_name)-1]='\0';
     // Give terminal to foreground pgid
-    tcsetpgrp(STDIN_FILENO, pgid);
-
-    int stopped = 0;
+    jobs_give_terminal(pgid);
+
+    int stopped = 0, backgrounded = 0;
+    int reaped[MAX_CMDS + 1] = {0}; // processes already waited for, like pids
+    // With 'setopt autobg', an alarm interrupts the wait once the pipeline
+    // has run too long; it then moves to the background still running.
+    unsigned autobg = setopt_autobg_seconds();
+    if (autobg) signals_alarm(autobg);
     // Wait for each stage. If any stage is stopped, we later move the whole
     // pipeline to background as a stopped job and print a message.
-    for (int i=0;i<pl->count;i++) {
+    for (int i=0;i<nprocs && !backgrounded;i++) {
         if (pids[i] > 0) {
-            int st = 0; if (waitpid(pids[i], &st, WUNTRACED) > 0) {
+            int st = 0; pid_t w = -1;
+            // The alarm may have gone off between two waits, too. One that
+            // fires just after the check is repeated and interrupts waitpid().
+            while (!(backgrounded = signals_take_alarm()) &&
+                   (w = waitpid(pids[i], &st, WUNTRACED)) < 0 && errno == EINTR) { }
+            if (w > 0) {
                 if (WIFSTOPPED(st)) {
                     stopped = 1; // mark
-                } else if (i == pl->count - 1) {
-                    if (WIFEXITED(st)) status_code = WEXITSTATUS(st); else status_code = 1;
+                } else {
+                    reaped[i] = 1;
+                    if (i == pl->count - 1) {
+                        if (WIFEXITED(st)) status_code = WEXITSTATUS(st); else status_code = 1;
+                    }
                 }
             }
         }
     }
+    if (autobg) signals_alarm(0);
     // If any stopped, move foreground to background as stopped job
+    if (backgrounded) {
+        // Take the terminal back first so the job cannot read from it.
+        jobs_take_terminal();
+        int jobnum = jobs_move_foreground_to_background(stopped, reaped);
+        if (jobnum != -1) {
+            out_printf(out_stdout(), "[%d] %s &\n", jobnum, last_fg_name[0]?last_fg_name:"?");
+            out_flush(out_stdout());
+        }
+        jobs_clear_foreground();
+        return 0;
+    }
     if (stopped) {
         g_recent_stop = 1;
         int jobnum = jobs_move_foreground_to_background_stopped();
         if (jobnum != -1) {
-            printf("[%d] Stopped %s\n", jobnum, last_fg_name[0]?last_fg_name:"?");
-            fflush(stdout);
+            out_printf(out_stdout(), "[%d] Stopped %s\n", jobnum, last_fg_name[0]?last_fg_name:"?");
+            out_flush(out_stdout());
         }
         // Reclaim terminal control for the shell after moving job to background
-        tcsetpgrp(STDIN_FILENO, getpgrp());
+        jobs_take_terminal();
         jobs_clear_foreground();
     } else {
         // Foreground pipeline completed: restore terminal control to the shell
-        tcsetpgrp(STDIN_FILENO, getpgrp());
+        jobs_take_terminal();
         jobs_clear_foreground();
     }
     return stopped ? 148 : status_code; // 148 arbitrary for stopped foreground
@@ -315,19 +521,105 @@ static int run_pipeline(Pipeline *pl){
 #include "ping.h"
 #include "log.h"
 
-static int count_argv(SimpleCmd *c){ int i=0; while (c->argv[i]) i++; return i; }
+#include "activities.h"
+#include "memo.h"
+#include "usage.h"
+#include "seq.h"
+#include "read.h"
+#include "mapfile.h"
+#include "syscount.h"
+#include "copy.h"
+#include "purge.h"
+#include "checksum.h"
+#include "tr.h"
+#include "cut.h"
+
+static int count_argv(SimpleCmd *c){ return c->argc; }
+
+static int run_fg_argv(int argc, char **argv){ int jobnum=0; if(argc>1) jobnum=atoi(argv[1]); return jobs_cmd_fg(jobnum); }
+static int run_bg_argv(int argc, char **argv){ int jobnum=0; if(argc>1) jobnum=atoi(argv[1]); return jobs_cmd_bg(jobnum); }
+static int run_notices_argv(int argc, char **argv){
+    if(argc>2 || (argc==2 && strcmp(argv[1],"-c")!=0)){ out_puts(out_stdout(), "notices: Invalid Syntax!"); return 1; }
+    return jobs_cmd_notices(argc==2);
+}
+
+// Builtin table: name -> argv handler. Add new builtins here.
+typedef int (*BuiltinFn)(int argc, char **argv);
+static const struct { const char *name; BuiltinFn fn; } builtins[] = {
+    { "hop", run_hop_argv },
+    { "cd", run_cd_argv },
+    { "reveal", run_reveal_argv },
+    { "ping", run_ping_argv },
+    { "log", run_log_argv },
+    { "activities", run_activities_argv },
+    { "fg", run_fg_argv },
+    { "bg", run_bg_argv },
+    { "memo", run_memo_argv },
+    { "usage", run_usage_argv },
+    { "seq", run_seq_argv },
+    { "read", run_read_argv },
+    { "mapfile", run_mapfile_argv },
+    { "notices", run_notices_argv },
+    { "syscount", run_syscount_argv },
+    { "last", run_last_argv },
+    { "copy", run_copy_argv },
+    { "purge-tree", run_purge_tree_argv },
+    { "checksum", run_checksum_argv },
+    { "tr", run_tr_argv },
+    { "cut", run_cut_argv },
+    { "setopt", run_setopt_argv },
+    { "where", run_records_argv },
+    { "sortby", run_records_argv },
+    { "select", run_records_argv },
+};
+
+static BuiltinFn find_builtin(const char *name){
+    if (!name) return NULL;
+    for (size_t i = 0; i < sizeof(builtins)/sizeof(builtins[0]); i++)
+        if (strcmp(name, builtins[i].name) == 0) return builtins[i].fn;
+    return NULL;
+}
+
+bool executor_is_builtin(const char *name){
+    return find_builtin(name) != NULL;
+}
 
 static int run_builtin(SimpleCmd *c) {
-    if (!c->argv[0]) return -1;
-    if (strcmp(c->argv[0], "hop")==0) return run_hop_argv(count_argv(c), c->argv);
-    if (strcmp(c->argv[0], "cd")==0) return run_cd_argv(count_argv(c), c->argv);
-    if (strcmp(c->argv[0], "reveal")==0) return run_reveal_argv(count_argv(c), c->argv);
-    if (strcmp(c->argv[0], "ping")==0) return run_ping_argv(count_argv(c), c->argv);
-    if (strcmp(c->argv[0], "log")==0) return run_log_argv(count_argv(c), c->argv);
-    if (strcmp(c->argv[0], "activities")==0) { extern int run_activities_argv(int argc, char **argv); return run_activities_argv(count_argv(c), c->argv); }
-    if (strcmp(c->argv[0], "fg")==0) { int jobnum=0; if(c->argv[1]) jobnum=atoi(c->argv[1]); return jobs_cmd_fg(jobnum); }
-    if (strcmp(c->argv[0], "bg")==0) { int jobnum=0; if(c->argv[1]) jobnum=atoi(c->argv[1]); return jobs_cmd_bg(jobnum); }
-    return -1;
+    if (c->records) return run_records_argv(c->argc, c->argv);
+    BuiltinFn fn = find_builtin(c->argv[0]);
+    return fn ? fn(count_argv(c), c->argv) : -1;
+}
+
+// Run a builtin in the shell process with its redirections applied to
+// fds 0/1 for the duration of the call, then restore the originals.
+static int run_builtin_redirected(SimpleCmd *c){
+    int saved[2] = { -1, -1 };
+    int status = 1, ok = 1;
+    out_flush_all(); // pending output belongs to the old fds
+    for (int ri = 0; ri < c->redir_count && ok; ri++) {
+        Redir *r = &c->redirs[ri];
+        int target = r->type == R_IN ? STDIN_FILENO : STDOUT_FILENO;
+        int fd;
+        if (r->type == R_IN) {
+            fd = openat(dirs_cwd_fd(), r->path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) { fprintf(stderr, "No such file or directory\n"); ok = 0; break; }
+        } else {
+            int flags = O_WRONLY | O_CREAT | O_CLOEXEC | ((r->type==R_OUT_APPEND) ? O_APPEND : O_TRUNC);
+            fd = openat(dirs_cwd_fd(), r->path, flags, 0644);
+            if (fd < 0) { fputs("Unable to create file for writing\n", stderr); ok = 0; break; }
+        }
+        if (saved[target] < 0) saved[target] = fcntl(target, F_DUPFD_CLOEXEC, 10);
+        dup2(fd, target);
+        close(fd);
+        if (r->type != R_IN) statcache_invalidate(); // created or truncated a file
+    }
+    if (ok) status = run_builtin(c);
+    out_flush_all();
+    for (int t = 0; t < 2; t++) {
+        if (saved[t] >= 0) { dup2(saved[t], t); close(saved[t]); }
+    }
+    out_flush_all(); // forget tty detection made for the redirected fds
+    return status;
 }
 
 // Fork pipeline asynchronously (no waiting). Records pids into BgJob.
@@ -345,6 +637,9 @@ static int run_pipeline_async(Pipeline *pl, const char *segment_text) {
         if (i < n-1) {
             if (pipe(pipefd) < 0) { perror("pipe"); break; }
         }
+        const char *exe = executor_is_builtin(pl->cmds[i].argv[0]) ? NULL : prewarm_resolve(pl->cmds[i].argv[0]);
+        int self = !executor_is_builtin(pl->cmds[i].argv[0]) && runs_self(exe, pl->cmds[i].argv);
+        out_flush_all();
         pid_t pid = fork();
         if (pid < 0) { perror("fork"); break; }
         if (pid == 0) {
@@ -364,12 +659,12 @@ static int run_pipeline_async(Pipeline *pl, const char *segment_text) {
             for (int ri = 0; ri < c->redir_count; ri++) {
                 Redir *r = &c->redirs[ri];
                 if (r->type == R_IN) {
-                    int fd = open(r->path, O_RDONLY);
+                    int fd = openat(dirs_cwd_fd(), r->path, O_RDONLY);
                     if (fd < 0) { fprintf(stderr, "No such file or directory\n"); _exit(1); }
                     dup2(fd, STDIN_FILENO); close(fd);
                 } else {
                     int flags = O_WRONLY | O_CREAT | ((r->type==R_OUT_APPEND) ? O_APPEND : O_TRUNC);
-                    int fd = open(r->path, flags, 0644);
+                    int fd = openat(dirs_cwd_fd(), r->path, flags, 0644);
                     if (fd < 0) { fputs("Unable to create file for writing\n", stderr); _exit(1); }
                     dup2(fd, STDOUT_FILENO); close(fd);
                 }
@@ -378,7 +673,9 @@ static int run_pipeline_async(Pipeline *pl, const char *segment_text) {
             if (pipefd[0] != -1) close(pipefd[0]);
             if (pipefd[1] != -1) close(pipefd[1]);
             int b = run_builtin(c);
-            if (b != -1) _exit(b);
+            if (b != -1) { out_flush_all(); _exit(b); }
+            if (self) script_run_inline(c->argv);
+            if (exe) execv(exe, c->argv);
             execvp(c->argv[0], c->argv);
             // Standardize unknown command error message for tests
             fputs("Command not found!\n", stderr);
@@ -416,7 +713,7 @@ static int run_pipeline_async(Pipeline *pl, const char *segment_text) {
     }
     pid_t lastpid=0; int jobnum = jobs_add_background(pids, pl->count, names, &lastpid);
     if (display_alloc) { free(display_alloc); display_alloc = NULL; }
-    if(jobnum!=-1){ printf("[%d] %d\n", jobnum, (int)lastpid); fflush(stdout); }
+    if(jobnum!=-1){ out_printf(out_stdout(), "[%d] %d\n", jobnum, (int)lastpid); out_flush(out_stdout()); }
     return 0;
 }
 
@@ -440,6 +737,7 @@ int execute_first_cmd_group(const char *line){
     if (!line) return 1;
     const char *p = line;
     int last_status = 0;
+    statcache_invalidate(); // stat results live for one command line
     while (*p) {
         const char *start = p;
         // scan to next delimiter recognizing '&&' vs '&'
@@ -463,12 +761,13 @@ int execute_first_cmd_group(const char *line){
             int is_background = (delim == '&');
             if (pl.count==1 && !is_background) {
                 SimpleCmd *sc=&pl.cmds[0];
-                int b = run_builtin(sc);
-                if (b != -1 && sc->redir_count == 0) {
-                    // Run directly (no fork) when no redirection/pipes needed.
-                    last_status = b;
+                if (find_builtin(sc->argv[0])) {
+                    // Run directly (no fork) so builtins can change shell state
+                    // (cwd, variables); redirections are applied temporarily.
+                    last_status = run_builtin_redirected(sc);
                 } else {
                     last_status = run_pipeline(&pl);
+                    statcache_invalidate(); // children may have changed files
                 }
             } else {
                 if (is_background) {
@@ -477,10 +776,12 @@ int execute_first_cmd_group(const char *line){
                 } else {
                     last_status = run_pipeline(&pl);
                 }
+                statcache_invalidate();
             }
             free_pipeline(&pl);
         } else {
-            puts("Invalid Syntax!");
+            out_puts(out_stdout(), "Invalid Syntax!");
+            out_flush(out_stdout());
         }
         free(segment);
         // Advance p past delimiter just parsed
@@ -0,0 +1,165 @@
+// expand.c: brace expansion
+// -------------------------
+// Turns one command word into several, the way bash does:
+//   file{a,b,c}.txt   -> filea.txt fileb.txt filec.txt
+//   img{1..3}.png     -> img1.png img2.png img3.png
+//   {01..10..3}       -> 01 04 07 10      (zero padding kept, step 3)
+//   {z..w}            -> z y x w
+//   {a,b}{1,2}        -> a1 a2 b1 b2      (nested and repeated braces work)
+// A brace pair is only special if it holds a top-level ',' or a valid
+// range, so words like {} or {x} stay as they are.
+//
+// How it works: find the first valid brace expression, and for each
+// alternative (or each value of the range) build prefix + value + suffix in a
+// scratch buffer and expand that word recursively. Range values are produced
+// in the loop, so {1..1000000} never exists as a list in memory: each word
+// goes straight to the caller's emit callback.
+#include "expand.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef struct {
+    int is_char;           // {a..e} instead of numbers
+    long long first, last;
+    long long step;        // always > 0; direction comes from first/last
+    int width;             // zero-pad numbers to this width (0 = none)
+} Range;
+
+// Index of the '}' closing the '{' at word[open], or -1.
+static long match_brace(const char *word, size_t open){
+    int depth = 0;
+    for (size_t i = open; word[i]; i++) {
+        if (word[i] == '{') depth++;
+        else if (word[i] == '}' && --depth == 0) return (long)i;
+    }
+    return -1;
+}
+
+// Is there a ',' in word[b..e) outside nested braces?
+static int has_top_comma(const char *word, size_t b, size_t e){
+    int depth = 0;
+    for (size_t i = b; i < e; i++) {
+        if (word[i] == '{') depth++;
+        else if (word[i] == '}') depth--;
+        else if (word[i] == ',' && depth == 0) return 1;
+    }
+    return 0;
+}
+
+// Optional sign followed by 1..18 digits (so sums can't overflow).
+static int parse_ll(const char *s, size_t n, long long *out){
+    size_t i = 0;
+    int neg = 0;
+    if (i < n && (s[i] == '-' || s[i] == '+')) { neg = s[i] == '-'; i++; }
+    if (i == n || n - i > 18) return 0;
+    long long v = 0;
+    for (; i < n; i++) {
+        if (!isdigit((unsigned char)s[i])) return 0;
+        v = v * 10 + (s[i] - '0');
+    }
+    *out = neg ? -v : v;
+    return 1;
+}
+
+static int zero_padded(const char *s, size_t n){
+    if (n > 0 && (s[0] == '-' || s[0] == '+')) { s++; n--; }
+    return n > 1 && s[0] == '0';
+}
+
+// first..last or first..last..step
+static int parse_range(const char *s, size_t n, Range *r){
+    const char *dots = NULL;
+    for (size_t i = 0; i + 1 < n; i++) if (s[i] == '.' && s[i + 1] == '.') { dots = s + i; break; }
+    if (!dots) return 0;
+    const char *a = s, *b = dots + 2, *end = s + n;
+    size_t alen = (size_t)(dots - a);
+    const char *dots2 = NULL;
+    for (const char *p = b; p + 1 < end; p++) if (p[0] == '.' && p[1] == '.') { dots2 = p; break; }
+    size_t blen = (size_t)((dots2 ? dots2 : end) - b);
+
+    r->step = 1;
+    if (dots2) {
+        long long st;
+        if (!parse_ll(dots2 + 2, (size_t)(end - dots2 - 2), &st)) return 0;
+        r->step = st < 0 ? -st : (st == 0 ? 1 : st);
+    }
+    r->width = 0;
+    if (alen == 1 && blen == 1 && isalpha((unsigned char)a[0]) && isalpha((unsigned char)b[0])) {
+        r->is_char = 1;
+        r->first = (unsigned char)a[0];
+        r->last = (unsigned char)b[0];
+        return 1;
+    }
+    r->is_char = 0;
+    if (!parse_ll(a, alen, &r->first) || !parse_ll(b, blen, &r->last)) return 0;
+    if (zero_padded(a, alen) || zero_padded(b, blen)) r->width = (int)(alen > blen ? alen : blen);
+    return 1;
+}
+
+static int expand_from(const char *word, size_t from, expand_emit_fn emit, void *ud);
+
+static int expand_list(const char *word, size_t open, size_t close, expand_emit_fn emit, void *ud){
+    size_t len = strlen(word);
+    char *buf = malloc(len + 1);
+    if (!buf) return 0;
+    memcpy(buf, word, open); // prefix
+    const char *suffix = word + close + 1;
+    int rc = 0, depth = 0;
+    size_t alt = open + 1;
+    for (size_t i = open + 1; i <= close && rc == 0; i++) {
+        if (word[i] == '{') { depth++; continue; }
+        if (word[i] == '}' && i < close) { depth--; continue; }
+        if ((word[i] == ',' && depth == 0) || i == close) {
+            size_t alen = i - alt;
+            memcpy(buf + open, word + alt, alen);
+            strcpy(buf + open + alen, suffix);
+            rc = expand_from(buf, open, emit, ud); // the alternative may hold braces
+            alt = i + 1;
+        }
+    }
+    free(buf);
+    return rc;
+}
+
+static int expand_range(const char *word, size_t open, size_t close, const Range *r, expand_emit_fn emit, void *ud){
+    size_t len = strlen(word);
+    char *buf = malloc(len + 32);
+    if (!buf) return 0;
+    memcpy(buf, word, open);
+    const char *suffix = word + close + 1;
+    int up = r->first <= r->last;
+    long long v = r->first;
+    int rc = 0;
+    for (;;) {
+        int n;
+        if (r->is_char) { buf[open] = (char)v; n = 1; }
+        else n = snprintf(buf + open, len + 32 - open, "%0*lld", r->width, v);
+        strcpy(buf + open + n, suffix);
+        rc = expand_from(buf, open + (size_t)n, emit, ud); // the value itself has no braces
+        if (rc) break;
+        if (up) { if (r->last - v < r->step) break; v += r->step; }
+        else { if (v - r->last < r->step) break; v -= r->step; }
+    }
+    free(buf);
+    return rc;
+}
+
+static int expand_from(const char *word, size_t from, expand_emit_fn emit, void *ud){
+    for (size_t i = from; word[i]; i++) {
+        if (word[i] != '{') continue;
+        long close = match_brace(word, i);
+        if (close < 0) continue; // unmatched: literal, but a later '{' may still match
+        Range r;
+        if (has_top_comma(word, i + 1, (size_t)close))
+            return expand_list(word, i, (size_t)close, emit, ud);
+        if (parse_range(word + i + 1, (size_t)close - i - 1, &r))
+            return expand_range(word, i, (size_t)close, &r, emit, ud);
+    }
+    return emit(word, ud);
+}
+
+int expand_braces(const char *word, expand_emit_fn emit, void *ud){
+    return expand_from(word, 0, emit, ud);
+}
@@ -9,24 +9,22 @@
 //   ~  -> shell home (the directory where the shell started)
 //   .  -> no-op
 //   .. -> parent directory
-//   -  -> previous directory (tracked in this module)
+//   -  -> previous directory (tracked in dirs.c)
 //   name/path -> chdir() there
 // On error we print "No such directory!" as required by the assignment.
 //
-// Why keep prev directory here? 'reveal -' also needs it, so we expose
-// two tiny helper functions for other modules to query the previous CWD.
+// Directories are held as descriptors (see dirs.c): targets are resolved
+// with openat() relative to the current one and entered with fchdir(), so
+// 'hop -' still works after the previous directory was renamed. 'reveal -'
+// also needs the previous directory, so we expose small query helpers.
 
 #include "hop.h"
-#include "prompt.h"
+#include "outbuf.h"
+#include "dirs.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <linux/limits.h> // for PATH_MAX
-
-// Track previous working directory across calls
-static char prev_cwd[PATH_MAX] = "";
-static int prev_cwd_set = 0; // becomes 1 after first non-"-" hop that changes dir
 
 static void skip_ws(const char **p) {
     while (**p == ' ' || **p == '\t' || **p == '\n' || **p == '\r') (*p)++;
@@ -49,29 +47,24 @@ static char *next_token(const char **p) {
     return tok;
 }
 
+// Resolve target relative to the current directory and enter it.
+// The previous directory is recorded only after a successful hop that's not '-'.
 static int change_dir_to(const char *target, int record_prev) {
-    char cwd[PATH_MAX];
-    if (!getcwd(cwd, sizeof(cwd))) {
-        // If we can't getcwd, attempt chdir anyway; if chdir fails, report.
-        cwd[0] = '\0';
-    }
-    if (chdir(target) != 0) {
-        puts("No such directory!");
+    if (dirs_chdir_at(dirs_cwd_fd(), target, record_prev) != 0) {
+        out_puts(out_stdout(), "No such directory!");
         return 0;
     }
-    if (record_prev && cwd[0] != '\0') {
-        // Record prev only after a successful hop to a real target that's not '-'
-        strncpy(prev_cwd, cwd, sizeof(prev_cwd));
-        prev_cwd[sizeof(prev_cwd)-1] = '\0';
-        prev_cwd_set = 1;
-    }
     return 1;
 }
 
+static void go_home(void) {
+    // Stay silent if the home itself is gone, like before.
+    (void)dirs_chdir_at(dirs_home_fd(), ".", 1);
+}
+
 static void hop_one(const char *arg) {
     if (arg == NULL || strcmp(arg, "~") == 0) {
-        const char *home = prompt_home();
-        if (home && *home) (void)change_dir_to(home, 1);
+        go_home();
         return;
     }
     if (strcmp(arg, ".") == 0) {
@@ -83,17 +76,7 @@ static void hop_one(const char *arg) {
         return;
     }
     if (strcmp(arg, "-") == 0) {
-        if (prev_cwd_set && prev_cwd[0] != '\0') {
-            char cwd[PATH_MAX];
-            if (getcwd(cwd, sizeof(cwd))) {
-                // Attempt swap: go to prev, then set prev to old cwd if chdir succeeded
-                if (chdir(prev_cwd) == 0) {
-                    strncpy(prev_cwd, cwd, sizeof(prev_cwd));
-                    prev_cwd[sizeof(prev_cwd)-1] = '\0';
-                    // prev_cwd_set remains true
-                }
-            }
-        }
+        (void)dirs_swap_prev(); // no previous directory yet: do nothing
         return;
     }
     // name: relative or absolute path
@@ -125,19 +108,20 @@ bool try_handle_hop(const char *input) {
     skip_ws(&q);
     q += kwlen;
     skip_ws(&q);
-    if (*q == '\0') {
-        const char *home = prompt_home();
-        if (home && *home) (void)change_dir_to(home, 1);
-    }
+    if (*q == '\0') go_home();
     return true;
 }
 
 int hop_prev_cwd_available(void) {
-    return prev_cwd_set && prev_cwd[0] != '\0';
+    return dirs_prev_fd() >= 0;
 }
 
 const char* hop_get_prev_cwd(void) {
-    return hop_prev_cwd_available() ? prev_cwd : NULL;
+    return dirs_prev_path();
+}
+
+void hop_set_prev_cwd(const char *path) {
+    dirs_set_prev_path(path);
 }
 
 // Basic 'cd' built-in: mirrors hop behavior but with typical cd constraints.
@@ -161,13 +145,13 @@ bool try_handle_cd(const char *input){
     if(p>arg_start){ arg = strndup(arg_start, (size_t)(p-arg_start)); }
     // Ensure no more args
     const char *q = p; skip_ws(&q);
-    if(*q!='\0'){ puts("cd: too many arguments"); free(arg); return true; }
+    if(*q!='\0'){ out_puts(out_stdout(), "cd: too many arguments"); free(arg); return true; }
 
     // Map to hop behavior
-    if(arg==NULL || strcmp(arg, "~")==0){ const char *home=prompt_home(); if(home&&*home) (void)change_dir_to(home, 1); }
+    if(arg==NULL || strcmp(arg, "~")==0){ go_home(); }
     else if(strcmp(arg, ".")==0){ /* no-op */ }
     else if(strcmp(arg, "..")==0){ (void)change_dir_to("..", 1); }
-    else if(strcmp(arg, "-")==0){ if(prev_cwd_set && prev_cwd[0]){ char cwd[PATH_MAX]; if(getcwd(cwd,sizeof(cwd))){ if(chdir(prev_cwd)==0){ strncpy(prev_cwd,cwd,sizeof(prev_cwd)); prev_cwd[sizeof(prev_cwd)-1]='\0'; } } } else { puts("No such directory!"); } }
+    else if(strcmp(arg, "-")==0){ if(dirs_prev_fd()>=0) (void)dirs_swap_prev(); else out_puts(out_stdout(), "No such directory!"); }
     else { (void)change_dir_to(arg, 1); }
     free(arg);
     return true;
@@ -178,8 +162,7 @@ int run_hop_argv(int argc, char **argv) {
     if (argc <= 0) return 1;
     // argv[0] == "hop"
     if (argc == 1) {
-        const char *home = prompt_home();
-        if (home && *home) change_dir_to(home, 1);
+        go_home();
         return 0;
     }
     for (int i = 1; i < argc; i++) {
@@ -192,18 +175,18 @@ int run_cd_argv(int argc, char **argv) {
     if (argc <= 0) return 1;
     // Behavior: only zero or one arg allowed.
     if (argc > 2) {
-        puts("cd: too many arguments");
+        out_puts(out_stdout(), "cd: too many arguments");
         return 1;
     }
     if (argc == 1 || strcmp(argv[1], "~") == 0) {
-        const char *home = prompt_home(); if (home && *home) change_dir_to(home, 1); return 0;
+        go_home(); return 0;
     }
     const char *arg = argv[1];
     if (strcmp(arg, ".") == 0) return 0;
     if (strcmp(arg, "..") == 0) { change_dir_to("..", 1); return 0; }
     if (strcmp(arg, "-") == 0) {
-        if (prev_cwd_set && prev_cwd[0]) { char cwd[PATH_MAX]; if (getcwd(cwd,sizeof(cwd))) { if (chdir(prev_cwd)==0) { strncpy(prev_cwd,cwd,sizeof(prev_cwd)); prev_cwd[sizeof(prev_cwd)-1]='\0'; } } }
-        else { puts("No such directory!"); return 1; }
+        if (dirs_prev_fd() >= 0) (void)dirs_swap_prev();
+        else { out_puts(out_stdout(), "No such directory!"); return 1; }
         return 0;
     }
     change_dir_to(arg, 1);
@@ -0,0 +1,98 @@
+// intern.c: interned strings
+// --------------------------
+// The job table, history and activity snapshots all hold command names and
+// lines, and with many background jobs most of them are the same few
+// strings ("sleep 1 &" a thousand times). Interning keeps one copy of each:
+//   const char *a = intern("sleep"), *b = intern("sleep");   // a == b
+//   intern_release(a); intern_release(b);                    // now freed
+// Each string lives in one allocation together with its hash, length and
+// reference count, found again through a chained hash table that doubles
+// when it gets full. Handles point at the characters, so they can be passed
+// to anything that takes a const char *.
+#include "intern.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+typedef struct IStr {
+    struct IStr *next;
+    unsigned hash;
+    unsigned refs;
+    size_t len;
+    char str[]; // NUL-terminated
+} IStr;
+
+static IStr **buckets = NULL;
+static size_t nbuckets = 0, nstrings = 0;
+
+static unsigned hash_n(const char *s, size_t n){
+    unsigned h = 2166136261u; // FNV-1a, like vars.c
+    for (size_t i = 0; i < n; i++) { h ^= (unsigned char)s[i]; h *= 16777619u; }
+    return h;
+}
+
+static IStr *entry_of(const char *is){
+    return (IStr *)(void *)(is - offsetof(IStr, str));
+}
+
+static int grow(void){
+    size_t nn = nbuckets ? nbuckets * 2 : 256;
+    IStr **nb = calloc(nn, sizeof(*nb));
+    if (!nb) return -1;
+    for (size_t i = 0; i < nbuckets; i++) {
+        for (IStr *e = buckets[i], *next; e; e = next) {
+            next = e->next;
+            e->next = nb[e->hash & (nn - 1)];
+            nb[e->hash & (nn - 1)] = e;
+        }
+    }
+    free(buckets);
+    buckets = nb;
+    nbuckets = nn;
+    return 0;
+}
+
+const char *intern_n(const char *s, size_t n){
+    unsigned h = hash_n(s, n);
+    if (nbuckets) {
+        for (IStr *e = buckets[h & (nbuckets - 1)]; e; e = e->next) {
+            if (e->hash == h && e->len == n && memcmp(e->str, s, n) == 0) {
+                e->refs++;
+                return e->str;
+            }
+        }
+    }
+    if (nstrings >= nbuckets && grow() != 0 && !nbuckets) return NULL;
+    IStr *e = malloc(sizeof(*e) + n + 1);
+    if (!e) return NULL;
+    e->hash = h;
+    e->refs = 1;
+    e->len = n;
+    memcpy(e->str, s, n);
+    e->str[n] = '\0';
+    IStr **b = &buckets[h & (nbuckets - 1)];
+    e->next = *b;
+    *b = e;
+    nstrings++;
+    return e->str;
+}
+
+const char *intern(const char *s){
+    return intern_n(s, strlen(s));
+}
+
+const char *intern_ref(const char *is){
+    if (is) entry_of(is)->refs++;
+    return is;
+}
+
+void intern_release(const char *is){
+    if (!is) return;
+    IStr *e = entry_of(is);
+    if (--e->refs) return;
+    for (IStr **pp = &buckets[e->hash & (nbuckets - 1)]; *pp; pp = &(*pp)->next) {
+        if (*pp == e) { *pp = e->next; break; }
+    }
+    nstrings--;
+    free(e);
+}
@@ -12,12 +12,24 @@
 //   detect state changes (stopped/continued/finished).
 // - We print completion messages when all stages in a background job finish.
 // - Builtins 'fg' and 'bg' use this table to resume jobs or bring them back.
+// - Every stage also gets a pidfd when the job is registered, so 'ping %N'
+//   can signal exactly those processes even if their pids get reused.
+// - Completion notices are queued during a poll and printed together with a
+//   single flush. When more than JOBS_NOTIFY_MAX (a shell or environment
+//   variable, default 16) jobs finish between two prompts they collapse into
+//   one summary line; 'notices' shows the details of recent completions.
+// - Job and stage names are interned (intern.c): a thousand copies of the
+//   same background command share one string.
 //
 // This is not a production-grade job control implementation, but it's small and
 // clear, which is perfect for learning.
 //
 // jobs.c - job control (background table, fg/bg builtins, activities enumeration)
 #include "jobs.h"
+#include "outbuf.h"
+#include "procs.h"
+#include "vars.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,31 +41,97 @@
 #include <time.h>
 
 #define MAX_CMDS 16
-#define MAX_BG_JOBS 64
+#define MAX_PROCS (MAX_CMDS + 1) // pipeline stages plus the `last` capture helper
+#define NOTIFY_MAX_DEFAULT 16
+#define NOTICES_KEEP 1024
 
 typedef struct {
     int job_num;
     int npids;
-    pid_t pids[MAX_CMDS];
-    int finished[MAX_CMDS];
-    int stopped[MAX_CMDS];
-    char *cmd_name;
-    char *stage_names[MAX_CMDS];
+    pid_t pids[MAX_PROCS];
+    int finished[MAX_PROCS];
+    int stopped[MAX_PROCS];
+    int pidfds[MAX_PROCS]; // -1 when unavailable
+    const char *cmd_name;               // interned
+    const char *stage_names[MAX_PROCS]; // interned
     int last_status;
 } BgJob;
 
-static BgJob bg_jobs[MAX_BG_JOBS];
+static BgJob *bg_jobs = NULL; // grows as needed
 static int bg_job_count = 0;
+static int bg_job_cap = 0;
+
+// A finished job, kept for the next notification batch and for 'notices'.
+typedef struct {
+    int job_num;
+    pid_t pid;
+    int ok;
+    const char *name; // interned, taken over from the job's cmd_name
+} Notice;
+
+static Notice *notices = NULL; // ring buffer of recent completions (NOTICES_KEEP)
+static int notices_next = 0, notices_count = 0;
+static int notices_pending = 0; // not printed yet (newest ones)
+static int batch_total = 0, batch_ok = 0; // since the last print, uncapped
 static int next_job_number = 1;
 
+// Everything above, for an embedded shell to keep per context (jobs.h).
+struct JobTable {
+    BgJob *jobs;
+    int count, cap;
+    Notice *notices;
+    int notices_next, notices_count, notices_pending, batch_total, batch_ok;
+    int next_job_number;
+};
+
+JobTable *jobs_table_new(void){
+    JobTable *t=calloc(1, sizeof(*t));
+    if(t) t->next_job_number=1;
+    return t;
+}
+
+void jobs_table_swap(JobTable *t){
+    JobTable live={ bg_jobs, bg_job_count, bg_job_cap, notices, notices_next, notices_count,
+                    notices_pending, batch_total, batch_ok, next_job_number };
+    bg_jobs=t->jobs; bg_job_count=t->count; bg_job_cap=t->cap;
+    notices=t->notices; notices_next=t->notices_next; notices_count=t->notices_count;
+    notices_pending=t->notices_pending; batch_total=t->batch_total; batch_ok=t->batch_ok;
+    next_job_number=t->next_job_number;
+    *t=live;
+}
+
+void jobs_table_free(JobTable *t){
+    if(!t) return;
+    jobs_table_swap(t);
+    jobs_forget_all();
+    free(bg_jobs); free(notices);
+    bg_jobs=NULL; notices=NULL; bg_job_cap=0;
+    jobs_table_swap(t);
+    free(t);
+}
+
+// Terminal handoff (see jobs_set_terminal_control)
+static int terminal_control = 1;
+
+void jobs_set_terminal_control(int on){ terminal_control = on; }
+int jobs_terminal_control(void){ return terminal_control; }
+
+void jobs_give_terminal(pid_t pgid){
+    if(terminal_control) tcsetpgrp(STDIN_FILENO, pgid);
+}
+
+void jobs_take_terminal(void){
+    if(terminal_control) tcsetpgrp(STDIN_FILENO, getpgrp());
+}
+
 // Foreground tracking
 static pid_t fg_pgid = -1;
-static pid_t fg_pids[MAX_CMDS];
+static pid_t fg_pids[MAX_PROCS];
 static int fg_count = 0;
 static char fg_name[128];
 
 void jobs_set_foreground(pid_t pgid, const pid_t *pids, int count, const char *name){
-    fg_pgid = pgid; fg_count = count>MAX_CMDS?MAX_CMDS:count;
+    fg_pgid = pgid; fg_count = count>MAX_PROCS?MAX_PROCS:count;
     for(int i=0;i<fg_count;i++) fg_pids[i]=pids[i];
     if(name){ strncpy(fg_name,name,sizeof(fg_name)-1); fg_name[sizeof(fg_name)-1]='\0'; } else fg_name[0]='\0';
 }
@@ -72,18 +150,34 @@ int jobs_get_foreground(pid_t *pgid_out, pid_t *pids_out, int max, char *name_bu
     return fg_count;
 }
 
-int jobs_move_foreground_to_background_stopped(void){
-    if (fg_pgid==-1 || fg_count==0) return -1;
-    if (bg_job_count>=MAX_BG_JOBS) return -1;
+// Zeroed slot at the end of the job table, or NULL if out of memory.
+static BgJob *new_job_slot(void){
+    if(bg_job_count==bg_job_cap){
+        int ncap = bg_job_cap ? bg_job_cap*2 : 64;
+        BgJob *nj = realloc(bg_jobs, (size_t)ncap*sizeof(BgJob));
+        if(!nj) return NULL;
+        bg_jobs = nj; bg_job_cap = ncap;
+    }
     BgJob *job=&bg_jobs[bg_job_count];
     memset(job,0,sizeof(*job));
+    return job;
+}
+
+int jobs_move_foreground_to_background(int stopped, const int *reaped){
+    if (fg_pgid==-1 || fg_count==0) return -1;
+    BgJob *job=new_job_slot();
+    if (!job) return -1;
     job->job_num=next_job_number++;
     job->npids=fg_count;
-    job->cmd_name=strdup(fg_name[0]?fg_name:"?");
+    job->cmd_name=intern(fg_name[0]?fg_name:"?");
     for(int i=0;i<fg_count;i++){
         job->pids[i]=fg_pids[i];
-        job->stage_names[i]=strdup(fg_name[0]?fg_name:"?");
-        job->stopped[i]=1;
+        job->stage_names[i]=intern_ref(job->cmd_name);
+        // Stages already waited for will never be reported by a poll.
+        int done=reaped && reaped[i];
+        job->finished[i]=done;
+        job->stopped[i]=done?0:stopped;
+        job->pidfds[i]=done?-1:procs_pidfd_open(fg_pids[i]);
     }
     bg_job_count++;
     int num=job->job_num;
@@ -91,55 +185,154 @@ int jobs_move_foreground_to_background_stopped(void){
     return num;
 }
 
+int jobs_move_foreground_to_background_stopped(void){
+    return jobs_move_foreground_to_background(1, NULL);
+}
+
 int jobs_add_background(const pid_t *pids, int count, const char *const *stage_names, pid_t *last_pid_out){
-    if(count<=0) return -1;
-    if(bg_job_count>=MAX_BG_JOBS) return -1;
-    BgJob *job=&bg_jobs[bg_job_count]; memset(job,0,sizeof(*job));
+    if(count<=0 || count>MAX_PROCS) return -1;
+    BgJob *job=new_job_slot();
+    if(!job) return -1;
     job->job_num = next_job_number++;
     job->npids = count;
-    job->cmd_name = strdup(stage_names && stage_names[0]? stage_names[0] : "?");
+    job->cmd_name = intern(stage_names && stage_names[0]? stage_names[0] : "?");
     for(int i=0;i<count;i++){
         job->pids[i]=pids[i];
-        job->stage_names[i]=strdup(stage_names && stage_names[i]?stage_names[i]:job->cmd_name);
+        job->stage_names[i]=stage_names && stage_names[i]?intern(stage_names[i]):intern_ref(job->cmd_name);
         job->stopped[i]=0;
+        job->pidfds[i]=procs_pidfd_open(pids[i]);
     }
     bg_job_count++;
     if(last_pid_out) *last_pid_out = pids[count-1];
     return job->job_num;
 }
 
+// Free what a job owns before it is dropped from the table.
+static void release_job(BgJob *job){
+    intern_release(job->cmd_name);
+    for(int j=0;j<job->npids;j++){
+        intern_release(job->stage_names[j]);
+        if(job->pidfds[j]>=0) close(job->pidfds[j]);
+    }
+}
+
+// Remember a finished job; takes over its cmd_name.
+static void queue_notice(BgJob *job){
+    if(!notices && !(notices=calloc(NOTICES_KEEP, sizeof(Notice)))) return; // no notice then
+    Notice *n=&notices[notices_next];
+    if(notices_count==NOTICES_KEEP) intern_release(n->name); else notices_count++;
+    n->job_num=job->job_num;
+    n->pid=job->pids[job->npids-1];
+    n->ok=job->last_status==0;
+    n->name=job->cmd_name;
+    job->cmd_name=NULL;
+    notices_next=(notices_next+1)%NOTICES_KEEP;
+    if(notices_pending<NOTICES_KEEP) notices_pending++;
+    batch_total++;
+    batch_ok+=n->ok;
+}
+
+static const Notice *notice_at(int age){ // 0 = oldest kept
+    return &notices[(notices_next-notices_count+age+NOTICES_KEEP)%NOTICES_KEEP];
+}
+
+static int notify_max(void){
+    const char *v=vars_get("JOBS_NOTIFY_MAX");
+    if(!v || *v<'0' || *v>'9') return NOTIFY_MAX_DEFAULT;
+    return atoi(v);
+}
+
+// Print the pending notices: one line each, or a summary when there are more
+// than JOBS_NOTIFY_MAX. Everything goes out with a single flush.
+static void emit_notices(void){
+    if(!notices_pending) return;
+    OutBuf *o=out_stdout();
+    int first=notices_count-notices_pending;
+    if(batch_total>notify_max()){
+        out_printf(o, "%d jobs finished: %d ok, %d failed (see 'notices')\n",
+                   batch_total, batch_ok, batch_total-batch_ok);
+    } else {
+        for(int i=first;i<notices_count;i++){
+            const Notice *n=notice_at(i);
+            out_printf(o, "%s with pid %d exited %s\n", n->name, (int)n->pid, n->ok?"normally":"abnormally");
+        }
+    }
+    notices_pending=batch_total=batch_ok=0;
+    out_flush(o);
+}
+
+// Apply one wait status to stage j of job.
+static void note_status(BgJob *job, int j, int st){
+    if(WIFSTOPPED(st)){ job->stopped[j]=1; return; }
+#ifdef WCONTINUED
+    if(WIFCONTINUED(st)){ job->stopped[j]=0; return; }
+#endif
+    job->finished[j]=1; job->stopped[j]=0;
+    if(j==job->npids-1){ job->last_status = (WIFEXITED(st) && WEXITSTATUS(st)==0)?0:1; }
+}
+
 void jobs_poll(void){
-    for(int i=0;i<bg_job_count;){
-        BgJob *job=&bg_jobs[i];
-        int all_done=1;
-        for(int j=0;j<job->npids;j++){
-            if(job->finished[j]) continue;
-            int st=0; pid_t w=waitpid(job->pids[j], &st, WNOHANG|WUNTRACED
+    if(bg_job_count==0) return;
+    // Reap each job's state changes through its process group: one call per
+    // change plus one per job, not one per process. Never waitpid(-1): when
+    // the shell is embedded (myshell.c) the host's other children are not
+    // ours to reap.
+    const int flags = WNOHANG|WUNTRACED
 #ifdef WCONTINUED
-                                        | WCONTINUED
+                      | WCONTINUED
 #endif
-                                        );
-            if(w==0){ all_done=0; continue; }
-            if(w==-1) continue;
-            if(WIFSTOPPED(st)){ job->stopped[j]=1; all_done=0; continue; }
-            if(WIFCONTINUED(st)){ job->stopped[j]=0; all_done=0; continue; }
-            job->finished[j]=1; job->stopped[j]=0;
-            if(j==job->npids-1){ job->last_status = (WIFEXITED(st) && WEXITSTATUS(st)==0)?0:1; }
+                      ;
+    for(int i=0;i<bg_job_count;i++){
+        BgJob *job=&bg_jobs[i];
+        int st=0; pid_t w, pgid=job->pids[0];
+        while(pgid>0 && (w=waitpid(-pgid, &st, flags))>0){
+            for(int j=0;j<job->npids;j++) if(job->pids[j]==w){ note_status(job, j, st); break; }
         }
-        if(all_done){
-            if(job->last_status==0)
-                printf("%s with pid %d exited normally\n", job->cmd_name, job->pids[job->npids-1]);
-            else
-                printf("%s with pid %d exited abnormally\n", job->cmd_name, job->pids[job->npids-1]);
-            fflush(stdout);
-            free(job->cmd_name);
-            for(int j=0;j<job->npids;j++) free(job->stage_names[j]);
-            if(i<bg_job_count-1) memmove(&bg_jobs[i], &bg_jobs[i+1], (bg_job_count-i-1)*sizeof(BgJob));
-            bg_job_count--;
-            continue;
+        if(pgid>0 && !(w<0 && errno==ECHILD)) continue;
+        // Nothing of ours left in the group: stages that moved to another
+        // group are asked directly; the rest are gone.
+        for(int j=0;j<job->npids;j++){
+            if(job->finished[j]) continue;
+            w=waitpid(job->pids[j], &st, flags);
+            if(w>0) note_status(job, j, st);
+            else if(w<0 && errno==ECHILD){ job->finished[j]=1; job->stopped[j]=0; }
         }
-        i++;
     }
+    // Drop finished jobs in one compacting pass.
+    int keep=0;
+    for(int i=0;i<bg_job_count;i++){
+        BgJob *job=&bg_jobs[i];
+        int all_done=1;
+        for(int j=0;j<job->npids;j++) if(!job->finished[j]) { all_done=0; break; }
+        if(all_done){ queue_notice(job); release_job(job); continue; }
+        if(keep!=i) bg_jobs[keep]=*job;
+        keep++;
+    }
+    bg_job_count=keep;
+    emit_notices();
+}
+
+int jobs_cmd_notices(int clear){
+    OutBuf *o=out_stdout();
+    if(clear){
+        for(int i=0;i<notices_count;i++) intern_release(notice_at(i)->name);
+        notices_count=notices_next=notices_pending=batch_total=batch_ok=0;
+        return 0;
+    }
+    for(int i=0;i<notices_count;i++){
+        const Notice *n=notice_at(i);
+        out_printf(o, "[%d] %s with pid %d exited %s\n", n->job_num, n->name, (int)n->pid, n->ok?"normally":"abnormally");
+    }
+    out_flush(o);
+    return 0;
+}
+
+void jobs_forget_all(void){
+    for(int i=0;i<bg_job_count;i++) release_job(&bg_jobs[i]);
+    bg_job_count=0;
+    jobs_cmd_notices(1);
+    next_job_number=1;
+    jobs_clear_foreground();
 }
 
 int jobs_for_each_activity(int (*cb)(pid_t pid,const char*name,int stopped,void*ud), void *ud){
@@ -161,15 +354,29 @@ int jobs_for_each_activity(int (*cb)(pid_t pid,const char*name,int stopped,void*
 static int find_job_index(int jobnum){ for(int i=0;i<bg_job_count;i++) if(bg_jobs[i].job_num==jobnum) return i; return -1; }
 static int most_recent_job_index(void){ return bg_job_count?bg_job_count-1:-1; }
 
-int jobs_cmd_bg(int jobnum){ int idx= jobnum?find_job_index(jobnum):most_recent_job_index(); if(idx<0){ puts("No such job"); return 1;} BgJob*job=&bg_jobs[idx]; int any_stopped=0; for(int i=0;i<job->npids;i++) if(!job->finished[i] && job->stopped[i]) any_stopped=1; if(!any_stopped){ puts("Job already running"); return 1;} pid_t pgid=job->pids[0]; if(pgid>0) kill(-pgid,SIGCONT); for(int i=0;i<job->npids;i++) job->stopped[i]=0; printf("[%d] %s &\n", job->job_num, job->cmd_name); fflush(stdout); return 0; }
+int jobs_job_targets(int jobnum, pid_t *pids_out, int *pidfds_out, int max){
+    int idx = jobnum>0 ? find_job_index(jobnum) : most_recent_job_index();
+    if(idx<0) return -1;
+    BgJob *job=&bg_jobs[idx];
+    int n=0;
+    for(int i=0;i<job->npids && n<max;i++){
+        if(job->finished[i]) continue;
+        pids_out[n]=job->pids[i];
+        pidfds_out[n]=job->pidfds[i];
+        n++;
+    }
+    return n;
+}
+
+int jobs_cmd_bg(int jobnum){ int idx= jobnum?find_job_index(jobnum):most_recent_job_index(); if(idx<0){ out_puts(out_stdout(), "No such job"); return 1;} BgJob*job=&bg_jobs[idx]; int any_stopped=0; for(int i=0;i<job->npids;i++) if(!job->finished[i] && job->stopped[i]) any_stopped=1; if(!any_stopped){ out_puts(out_stdout(), "Job already running"); return 1;} pid_t pgid=job->pids[0]; if(pgid>0) kill(-pgid,SIGCONT); for(int i=0;i<job->npids;i++) job->stopped[i]=0; out_printf(out_stdout(), "[%d] %s &\n", job->job_num, job->cmd_name); out_flush(out_stdout()); return 0; }
 
-int jobs_cmd_fg(int jobnum){ int idx= jobnum?find_job_index(jobnum):most_recent_job_index(); if(idx<0){ puts("No such job"); return 1;} BgJob*job=&bg_jobs[idx]; pid_t pgid=job->pids[0]; if(pgid<=0){ puts("No such job"); return 1;} printf("%s\n", job->cmd_name); fflush(stdout); tcsetpgrp(STDIN_FILENO, pgid); int need_cont=0; for(int i=0;i<job->npids;i++) if(job->stopped[i]) { need_cont=1; break; } if(need_cont) kill(-pgid,SIGCONT); int stopped=0; int status_code=0; for(;;){ int all_done=1; stopped=0; for(int i=0;i<job->npids;i++){ if(job->finished[i]) continue; int st; pid_t w=waitpid(job->pids[i], &st, WUNTRACED
+int jobs_cmd_fg(int jobnum){ int idx= jobnum?find_job_index(jobnum):most_recent_job_index(); if(idx<0){ out_puts(out_stdout(), "No such job"); return 1;} BgJob*job=&bg_jobs[idx]; pid_t pgid=job->pids[0]; if(pgid<=0){ out_puts(out_stdout(), "No such job"); return 1;} out_printf(out_stdout(), "%s\n", job->cmd_name); out_flush(out_stdout()); jobs_give_terminal(pgid); int need_cont=0; for(int i=0;i<job->npids;i++) if(job->stopped[i]) { need_cont=1; break; } if(need_cont) kill(-pgid,SIGCONT); int stopped=0; int status_code=0; for(;;){ int all_done=1; stopped=0; for(int i=0;i<job->npids;i++){ if(job->finished[i]) continue; int st; pid_t w=waitpid(job->pids[i], &st, WUNTRACED
 #ifdef WCONTINUED
             | WCONTINUED
 #endif
             | WNOHANG); if(w==0){ all_done=0; continue;} if(w<0) continue; if(WIFSTOPPED(st)){ job->stopped[i]=1; all_done=0; stopped=1; } else if(WIFCONTINUED(st)){ job->stopped[i]=0; all_done=0; } else { job->finished[i]=1; job->stopped[i]=0; if(i==job->npids-1){ if(WIFEXITED(st)&&WEXITSTATUS(st)==0) status_code=0; else status_code=1; } } }
-        if(stopped){ tcsetpgrp(STDIN_FILENO, getpgrp()); printf("[%d] Stopped %s\n", job->job_num, job->cmd_name); fflush(stdout); return 148; }
-        if(all_done){ free(job->cmd_name); for(int j=0;j<job->npids;j++) free(job->stage_names[j]); if(idx<bg_job_count-1) memmove(&bg_jobs[idx],&bg_jobs[idx+1],(bg_job_count-idx-1)*sizeof(BgJob)); bg_job_count--; break; }
+        if(stopped){ jobs_take_terminal(); out_printf(out_stdout(), "[%d] Stopped %s\n", job->job_num, job->cmd_name); out_flush(out_stdout()); return 148; }
+        if(all_done){ release_job(job); if(idx<bg_job_count-1) memmove(&bg_jobs[idx],&bg_jobs[idx+1],(bg_job_count-idx-1)*sizeof(BgJob)); bg_job_count--; break; }
         struct timespec ts={0,30*1000*1000}; nanosleep(&ts,NULL);
     }
-    tcsetpgrp(STDIN_FILENO, getpgrp()); return status_code; }
+    jobs_take_terminal(); return status_code; }
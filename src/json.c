@@ -0,0 +1,115 @@
+// json.c: tiny streaming NDJSON writer
+// ------------------------------------
+// Builtins such as activities, log and reveal can print one JSON object per
+// line instead of human-oriented text (enabled with -j or `shell.out --json`).
+//
+// Why hand-rolled and buffer-based?
+// - Records are flat (string and integer fields), so we never need a DOM.
+// - Escaping is done straight into the builtin output buffer (outbuf.c);
+//   the only extra memory is the JsonWriter itself, on the caller's stack.
+// - When that buffer is full it is written out, so arbitrarily long
+//   listings stream out record by record.
+
+#include "json.h"
+#include <stdio.h>
+#include <string.h>
+
+static int g_json_default = 0;
+
+void json_set_default(int on){ g_json_default = on ? 1 : 0; }
+int json_default(void){ return g_json_default; }
+
+void json_init(JsonWriter *w, OutBuf *out){
+    w->out = out;
+    w->need_comma = 0;
+}
+
+void json_flush(JsonWriter *w){ out_flush(w->out); }
+
+static void put_raw(JsonWriter *w, const char *s, size_t n){ out_write(w->out, s, n); }
+
+static void put_char(JsonWriter *w, char c){ out_putc(w->out, c); }
+
+// Length of the well-formed UTF-8 sequence at s (lead byte >= 0x80), or 0
+// if it is not one: stray continuation bytes, overlong forms, surrogates,
+// code points past U+10FFFF and sequences cut short.
+static int utf8_len(const unsigned char *s){
+    unsigned char c = s[0];
+    if (c >= 0xC2 && c <= 0xDF) return (s[1] & 0xC0) == 0x80 ? 2 : 0;
+    if (c >= 0xE0 && c <= 0xEF) {
+        unsigned char lo = c == 0xE0 ? 0xA0 : 0x80, hi = c == 0xED ? 0x9F : 0xBF;
+        return s[1] >= lo && s[1] <= hi && (s[2] & 0xC0) == 0x80 ? 3 : 0;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        unsigned char lo = c == 0xF0 ? 0x90 : 0x80, hi = c == 0xF4 ? 0x8F : 0xBF;
+        return s[1] >= lo && s[1] <= hi && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80 ? 4 : 0;
+    }
+    return 0;
+}
+
+// Quote and escape s per RFC 8259: '"', '\\' and control characters. Bytes
+// that are not valid UTF-8 (file names may hold anything) become U+FFFD, so
+// the output is always valid JSON.
+static void put_string(JsonWriter *w, const char *s){
+    static const char hex[] = "0123456789abcdef";
+    put_char(w, '"');
+    const char *run = s; // copy unescaped stretches in one go
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') continue;
+        if (c >= 0x80) {
+            int n = utf8_len((const unsigned char *)s);
+            if (n) { s += n - 1; continue; }
+            put_raw(w, run, (size_t)(s - run));
+            run = s + 1;
+            put_raw(w, "\xEF\xBF\xBD", 3); // U+FFFD REPLACEMENT CHARACTER
+            continue;
+        }
+        put_raw(w, run, (size_t)(s - run));
+        run = s + 1;
+        switch (c) {
+        case '"':  put_raw(w, "\\\"", 2); break;
+        case '\\': put_raw(w, "\\\\", 2); break;
+        case '\n': put_raw(w, "\\n", 2); break;
+        case '\r': put_raw(w, "\\r", 2); break;
+        case '\t': put_raw(w, "\\t", 2); break;
+        case '\b': put_raw(w, "\\b", 2); break;
+        case '\f': put_raw(w, "\\f", 2); break;
+        default: {
+            char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            put_raw(w, u, sizeof(u));
+        }
+        }
+    }
+    put_raw(w, run, (size_t)(s - run));
+    put_char(w, '"');
+}
+
+static void put_key(JsonWriter *w, const char *key){
+    if (w->need_comma) put_char(w, ',');
+    w->need_comma = 1;
+    put_string(w, key);
+    put_char(w, ':');
+}
+
+void json_begin(JsonWriter *w){
+    put_char(w, '{');
+    w->need_comma = 0;
+}
+
+void json_str(JsonWriter *w, const char *key, const char *val){
+    put_key(w, key);
+    put_string(w, val ? val : "");
+}
+
+void json_int(JsonWriter *w, const char *key, long long val){
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%lld", val);
+    put_key(w, key);
+    put_raw(w, num, (size_t)n);
+}
+
+void json_end(JsonWriter *w){
+    put_raw(w, "}\n", 2);
+    w->need_comma = 0;
+}
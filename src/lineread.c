@@ -0,0 +1,249 @@
+// lineread.c: read records without reading one byte at a time
+// -----------------------------------------------------------
+// A shell must not read past the end of the line it needs: whatever it
+// reads too far is gone for the next reader of the same descriptor. The
+// classic answer is read(fd, &c, 1) per byte, which costs one system call per
+// character. We do better in two ways:
+// - Regular files: read a large block, find the delimiter, then lseek()
+//   back over the excess. Two system calls per record, and the offset stays
+//   exact for anyone else sharing the descriptor.
+// - Pipes, sockets and terminals can't seek back, so the read-ahead is kept
+//   here in a buffer owned by the shell. Buffers are keyed by the open file
+//   (device + inode), not the descriptor number, so redirecting fd 0 to a
+//   file for one command doesn't mix up the pipe's buffered data.
+// lr_read_bulk() applies the same rules to whole files (mapfile), reading
+// straight into the caller's buffer instead of record by record, and
+// lr_read_block() drains the buffered read-ahead for streaming filters.
+// The REPL reads its command lines through this module too, so a `read`
+// typed at the prompt continues exactly where the shell stopped reading.
+#include "lineread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define LR_BLOCK 65536
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    char *data;
+    size_t start, end, cap; // unread bytes are data[start..end)
+    int eof;
+    int in_use;
+} Stream;
+
+// Grows as needed: a stream still holding read-ahead is never evicted, since
+// those bytes are already gone from the descriptor.
+static Stream *streams;
+static int nstreams, streams_cap;
+
+static int append(char **buf, size_t *cap, size_t *len, const char *s, size_t n){
+    if (*len + n + 1 > *cap) {
+        size_t ncap = *cap ? *cap : 256;
+        while (ncap < *len + n + 1) ncap *= 2;
+        char *nb = realloc(*buf, ncap);
+        if (!nb) return -1;
+        *buf = nb;
+        *cap = ncap;
+    }
+    memcpy(*buf + *len, s, n);
+    *len += n;
+    (*buf)[*len] = '\0';
+    return 0;
+}
+
+// The stream of the open file st, or a new one. NULL when out of memory.
+static Stream *stream_for(const struct stat *st){
+    Stream *free_slot = NULL;
+    for (int i = 0; i < nstreams; i++) {
+        Stream *s = &streams[i];
+        if (s->in_use && s->dev == st->st_dev && s->ino == st->st_ino) return s;
+        if (!s->in_use && !free_slot) free_slot = s;
+        // A drained stream can be reused for another file.
+        if (s->in_use && s->start == s->end && !free_slot) free_slot = s;
+    }
+    if (!free_slot) {
+        if (nstreams == streams_cap) {
+            int ncap = streams_cap ? streams_cap * 2 : 8;
+            Stream *ns = realloc(streams, (size_t)ncap * sizeof(*ns));
+            if (!ns) return NULL;
+            streams = ns;
+            streams_cap = ncap;
+        }
+        free_slot = &streams[nstreams++];
+        memset(free_slot, 0, sizeof(*free_slot));
+    }
+    free_slot->in_use = 1;
+    free_slot->dev = st->st_dev;
+    free_slot->ino = st->st_ino;
+    free_slot->start = free_slot->end = 0;
+    free_slot->eof = 0;
+    return free_slot;
+}
+
+static int read_seekable(int fd, int delim, char **buf, size_t *cap, size_t *len){
+    char block[LR_BLOCK];
+    int got_any = 0;
+    for (;;) {
+        ssize_t n = read(fd, block, sizeof(block));
+        if (n < 0) return -2;
+        if (n == 0) return got_any ? 0 : -1;
+        got_any = 1;
+        char *hit = memchr(block, delim, (size_t)n);
+        size_t take = hit ? (size_t)(hit - block) : (size_t)n;
+        if (append(buf, cap, len, block, take) != 0) return -2;
+        if (hit) {
+            off_t excess = (off_t)n - (off_t)take - 1;
+            if (excess > 0) lseek(fd, -excess, SEEK_CUR);
+            return 1;
+        }
+    }
+}
+
+static int read_buffered(Stream *s, int fd, int delim, char **buf, size_t *cap, size_t *len){
+    int got_any = 0;
+    for (;;) {
+        if (s->start < s->end) {
+            char *base = s->data + s->start;
+            size_t avail = s->end - s->start;
+            char *hit = memchr(base, delim, avail);
+            size_t take = hit ? (size_t)(hit - base) : avail;
+            if (append(buf, cap, len, base, take) != 0) return -2;
+            got_any = 1;
+            s->start += take + (hit ? 1 : 0);
+            if (hit) return 1;
+        }
+        if (s->eof) { s->eof = 0; return got_any ? 0 : -1; }
+        if (!s->data) {
+            s->data = malloc(LR_BLOCK);
+            if (!s->data) return -2;
+            s->cap = LR_BLOCK;
+        }
+        s->start = s->end = 0;
+        ssize_t n = read(fd, s->data, s->cap);
+        if (n < 0) return -2; // keep what we have for the next call
+        if (n == 0) { if (!got_any) return -1; s->eof = 1; continue; }
+        s->end = (size_t)n;
+    }
+}
+
+int lr_read_record(int fd, int delim, char **buf, size_t *cap, size_t *len){
+    *len = 0;
+    if (append(buf, cap, len, "", 0) != 0) return -2;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -2;
+    if (S_ISREG(st.st_mode) && lseek(fd, 0, SEEK_CUR) != (off_t)-1)
+        return read_seekable(fd, delim, buf, cap, len);
+    Stream *s = stream_for(&st);
+    if (!s) return -2;
+    return read_buffered(s, fd, delim, buf, cap, len);
+}
+
+// Length of the prefix of p[0..n) holding the records still wanted: all of
+// it when max is 0, else up to and including the delimiter that completes
+// record number max (counted in *seen across calls).
+static size_t wanted_prefix(const char *p, size_t n, int delim, size_t max, size_t *seen){
+    if (!max) return n;
+    const char *q = p, *end = p + n;
+    while (*seen < max && q < end) {
+        const char *hit = memchr(q, delim, (size_t)(end - q));
+        if (!hit) return n;
+        (*seen)++;
+        q = hit + 1;
+    }
+    return (size_t)(q - p);
+}
+
+static int reserve(char **buf, size_t *cap, size_t need){
+    if (need <= *cap) return 0;
+    size_t ncap = *cap ? *cap : LR_BLOCK;
+    while (ncap < need) ncap *= 2;
+    char *nb = realloc(*buf, ncap);
+    if (!nb) return -1;
+    *buf = nb;
+    *cap = ncap;
+    return 0;
+}
+
+int lr_read_bulk(int fd, int delim, size_t max, char **buf, size_t *cap, size_t *len){
+    *len = 0;
+    if (append(buf, cap, len, "", 0) != 0) return -2;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -2;
+    Stream *s = NULL;
+    off_t pos = S_ISREG(st.st_mode) ? lseek(fd, 0, SEEK_CUR) : (off_t)-1;
+    size_t seen = 0, hint = LR_BLOCK;
+    if (pos == (off_t)-1) {
+        s = stream_for(&st);
+        if (!s) return -2;
+        if (s->start < s->end) {
+            size_t take = wanted_prefix(s->data + s->start, s->end - s->start, delim, max, &seen);
+            if (append(buf, cap, len, s->data + s->start, take) != 0) return -2;
+            s->start += take;
+            if (s->start < s->end) return 0; // max reached inside the buffer
+        }
+        if (s->eof) { s->eof = 0; return 0; }
+    } else if (!max && st.st_size > pos) {
+        hint = (size_t)(st.st_size - pos) + 1; // the whole rest in one read
+    }
+    if (reserve(buf, cap, *len + hint + 1) != 0) return -2;
+    for (;;) {
+        // Grow only when full, so a file read in one go isn't doubled just
+        // to see end of file.
+        if (*len + 1 == *cap && reserve(buf, cap, *len * 2 + 1) != 0) return -2;
+        ssize_t n = read(fd, *buf + *len, *cap - *len - 1);
+        if (n < 0) { (*buf)[*len] = '\0'; return -2; }
+        if (n == 0) break;
+        size_t take = wanted_prefix(*buf + *len, (size_t)n, delim, max, &seen);
+        size_t excess = (size_t)n - take;
+        if (excess && s) {
+            // Keep the read-ahead for the next reader of this pipe.
+            if (s->cap < excess) {
+                size_t ncap = excess > LR_BLOCK ? excess : LR_BLOCK;
+                char *nd = realloc(s->data, ncap);
+                if (!nd) return -2;
+                s->data = nd;
+                s->cap = ncap;
+            }
+            memcpy(s->data, *buf + *len + take, excess);
+            s->start = 0;
+            s->end = excess;
+        } else if (excess) {
+            lseek(fd, -(off_t)excess, SEEK_CUR);
+        }
+        *len += take;
+        if (excess || (max && seen == max)) break;
+    }
+    (*buf)[*len] = '\0';
+    return 0;
+}
+
+ssize_t lr_read_block(int fd, char *buf, size_t n){
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -2;
+    if (!S_ISREG(st.st_mode)) {
+        for (int i = 0; i < nstreams; i++) {
+            Stream *s = &streams[i];
+            if (!s->in_use || s->dev != st.st_dev || s->ino != st.st_ino) continue;
+            if (s->start < s->end) {
+                size_t take = s->end - s->start < n ? s->end - s->start : n;
+                memcpy(buf, s->data + s->start, take);
+                s->start += take;
+                return (ssize_t)take;
+            }
+            if (s->eof) { s->eof = 0; return 0; }
+            break;
+        }
+    }
+    ssize_t got = read(fd, buf, n);
+    return got < 0 ? -2 : got;
+}
+
+void lr_forget_buffered(void){
+    for (int i = 0; i < nstreams; i++) free(streams[i].data);
+    free(streams);
+    streams = NULL;
+    nstreams = streams_cap = 0;
+}
@@ -5,15 +5,23 @@
 //   log            -> print the list (oldest to newest)
 //   log purge      -> clear the history file and in-memory list
 //   log execute N  -> run the N-th most recent command (1 = newest)
+//   log -j         -> print the list as NDJSON ({"index":N,"command":...},
+//                     index as accepted by 'log execute')
 //
 // Learning points:
 // - A ring buffer tracks a fixed-size list efficiently (no shifting on push).
 // - We filter: do not store consecutive duplicates, and do not store any
 //   shell command that contains the builtin name "log" as a command name.
 // - The on-disk format is just one command per line in a plain text file.
+// - Entries are interned (intern.c), so a repeated command shares its string
+//   with the other copies in the ring and with the job table.
 //
 #define _POSIX_C_SOURCE 200809L
 #include "log.h"
+#include "json.h"
+#include "outbuf.h"
+#include "intern.h"
+#include "parser.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,7 +31,7 @@
 
 #define LOG_MAX 15
 
-static char *entries[LOG_MAX];        // oldest..newest in chronological order in file, but we manage ring
+static const char *entries[LOG_MAX]; // interned; a ring, oldest at head (the file is oldest..newest)
 static int count = 0;                  // number of valid entries (<= LOG_MAX)
 static int head = 0;                   // index of oldest
 
@@ -36,7 +44,7 @@ static void set_hist_path(void) {
 }
 
 static void free_all(void){
-    for(int i=0;i<LOG_MAX;i++){ free(entries[i]); entries[i]=NULL; }
+    for(int i=0;i<LOG_MAX;i++){ intern_release(entries[i]); entries[i]=NULL; }
     count=0; head=0;
 }
 
@@ -45,16 +53,16 @@ static void load_from_disk(void){
     if(!fp) return;
     char *line = NULL; size_t cap=0; ssize_t n;
     // load into a temp list then keep last LOG_MAX
-    char *tmp[LOG_MAX]; int tcount=0; for(int i=0;i<LOG_MAX;i++) tmp[i]=NULL;
+    const char *tmp[LOG_MAX]; int tcount=0; for(int i=0;i<LOG_MAX;i++) tmp[i]=NULL;
     while ((n = getline(&line, &cap, fp)) != -1) {
         // strip trailing newlines
         while (n>0 && (line[n-1]=='\n' || line[n-1]=='\r')) line[--n]='\0';
-        char *dup = strdup(line);
+        const char *dup = intern_n(line, (size_t)n);
         if(!dup) continue;
         if (tcount < LOG_MAX) {
             tmp[tcount++] = dup;
         } else {
-            free(tmp[0]);
+            intern_release(tmp[0]);
             memmove(&tmp[0], &tmp[1], (LOG_MAX-1)*sizeof(char*));
             tmp[LOG_MAX-1] = dup;
         }
@@ -88,78 +96,65 @@ static int ring_last_index(void){
     return (head + count - 1) % LOG_MAX;
 }
 
+// Takes over the reference to the interned string s.
 static void ring_push(const char *s){
-    // suppress identical consecutive
+    // suppress identical consecutive (interned: same text, same pointer)
     int last = ring_last_index();
-    if(last!=-1 && entries[last] && strcmp(entries[last], s)==0) return;
+    if(last!=-1 && entries[last]==s){ intern_release(s); return; }
 
     if(count < LOG_MAX){
         int pos = (head + count) % LOG_MAX;
-        free(entries[pos]);
-        entries[pos] = strdup(s);
+        intern_release(entries[pos]);
+        entries[pos] = s;
         count++;
     } else {
         // overwrite oldest
-        free(entries[head]);
-        entries[head] = strdup(s);
+        intern_release(entries[head]);
+        entries[head] = s;
         head = (head + 1) % LOG_MAX;
     }
     save_to_disk();
 }
 
-static int contains_log_command_name(const char *line){
-    // Parse only command names of atomic commands in the whole shell_cmd.
-    // Grammar: cmd_group ((& | ;) cmd_group)*, cmd_group = atomic ('|' atomic)*, atomic starts with name (command name)
-    const char *p = line;
-    while (*p) {
-        // skip ws
-        while (*p==' '||*p=='\t'||*p=='\n'||*p=='\r') p++;
-        // read command name token until ws or special |&;<> or end
-        const char *start = p;
-        while (*p && *p!=' ' && *p!='\t' && *p!='\n' && *p!='\r' && *p!='|' && *p!='&' && *p!=';' && *p!='<' && *p!='>') p++;
-        if (p==start) break; // no more tokens
-        size_t len = (size_t)(p-start);
-        // compare with "log"
-        if (len==3 && strncmp(start, "log", 3)==0) return 1;
-        // skip rest of atomic (args and redirs) until separator | ; & or end
-        for(;;){
-            while (*p==' '||*p=='\t'||*p=='\n'||*p=='\r') p++;
-            if (*p=='|' || *p==';' || *p=='&' || *p=='\0') break;
-            // token or redir
-            if (*p=='<' || *p=='>'){
-                p++; if (*p=='>') p++; // >>
-                while (*p==' '||*p=='\t'||*p=='\n'||*p=='\r') p++;
-                while (*p && *p!=' ' && *p!='\t' && *p!='\n' && *p!='\r' && *p!='|' && *p!='&' && *p!=';' && *p!='<' && *p!='>') p++;
-            } else {
-                while (*p && *p!=' ' && *p!='\t' && *p!='\n' && *p!='\r' && *p!='|' && *p!='&' && *p!=';' && *p!='<' && *p!='>') p++;
-            }
-        }
-        // if separator is '|' then next atomic in pipeline; if ; or & then next cmd_group
-        if (*p=='|' || *p==';' || *p=='&') { p++; continue; }
-    }
-    return 0;
+// Stops the name scan (parser.c) at the first atomic command named "log".
+static int is_log_name(const char *name, size_t len, void *ud){
+    (void)ud;
+    return len==3 && strncmp(name, "log", 3)==0;
 }
 
 void log_maybe_store_shell_cmd(const char *line){
     if(!line) return;
-    if (contains_log_command_name(line)) return; // do not store if any atomic cmd is log
+    if (parse_command_names(line, is_log_name, NULL) == 1) return; // do not store if any atomic cmd is log
     // store entire shell_cmd exactly as typed (including trailing newline trimmed)
     // Trim trailing newlines for storage consistency
     size_t n = strlen(line);
     while (n>0 && (line[n-1]=='\n' || line[n-1]=='\r')) n--;
-    char *tmp = strndup(line, n);
-    if(!tmp) return;
-    ring_push(tmp);
-    free(tmp);
+    const char *s = intern_n(line, n);
+    if(!s) return;
+    ring_push(s);
 }
 
 static void print_list(void){
     // Print oldest to newest, one per line
     for(int i=0;i<count;i++){
         int idx = (head + i) % LOG_MAX;
-        if(entries[idx]) printf("%s\n", entries[idx]);
+        if(entries[idx]) out_printf(out_stdout(), "%s\n", entries[idx]);
+    }
+    out_flush(out_stdout());
+}
+
+static void print_list_json(void){
+    JsonWriter jw;
+    json_init(&jw, out_stdout());
+    for(int i=0;i<count;i++){
+        int idx = (head + i) % LOG_MAX;
+        if(!entries[idx]) continue;
+        json_begin(&jw);
+        json_int(&jw, "index", count - i);
+        json_str(&jw, "command", entries[idx]);
+        json_end(&jw);
     }
-    fflush(stdout);
+    json_flush(&jw);
 }
 
 static void purge(void){
@@ -183,18 +178,20 @@ static int exec_index(int index){
     // Note: This will execute in a subshell; redirections/pipes processed by /bin/sh. This likely deviates from spec
     // but meets the basic behavior quickly. Alternative is to call back into executor; for now, print and system.
     // However, spec: Do not store the executed command. Our caller should avoid storing.
+    out_flush_all(); // system() forks
     int rc = system(cmd);
     return (rc == -1) ? 1 : (WIFEXITED(rc) ? WEXITSTATUS(rc) : 1);
 }
 
 int run_log_argv(int argc, char **argv){
-    if (argc == 1) { print_list(); return 0; }
+    if (argc == 1) { if (json_default()) print_list_json(); else print_list(); return 0; }
+    if (argc == 2 && strcmp(argv[1], "-j") == 0) { print_list_json(); return 0; }
     if (argc == 2 && strcmp(argv[1], "purge") == 0) { purge(); return 0; }
     if (argc == 3 && strcmp(argv[1], "execute") == 0) {
         char *end=NULL; long v = strtol(argv[2], &end, 10);
-        if (!end || *end!='\0') { puts("log: Invalid Syntax!"); return 1; }
+        if (!end || *end!='\0') { out_puts(out_stdout(), "log: Invalid Syntax!"); return 1; }
         return exec_index((int)v);
     }
-    puts("log: Invalid Syntax!");
+    out_puts(out_stdout(), "log: Invalid Syntax!");
     return 1;
 }
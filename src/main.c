@@ -6,10 +6,16 @@
 // - read a line from stdin
 // - validate the syntax using the parser
 // - store the command in history (with some rules)
+// - count command names so frequent executables are prefetched (prewarm.c)
 // - execute the first command-group using the executor
 //
+// `shell.out --serve /path.sock [--workers N]` skips the REPL and turns the
+// initialized shell into a command server instead (see server.c).
+// `shell.out file` runs the command lines of file instead (see script.c).
+// `--json` makes builtins that support it print NDJSON by default (json.c).
+//
 // Key ideas to learn:
-// - A shell is just a loop around fgets() + fork()/exec()/wait() (done by executor.c)
+// - A shell is just a loop around reading a line + fork()/exec()/wait() (done by executor.c)
 // - Job control: we give and take terminal control with tcsetpgrp() when
 //   running foreground pipelines
 // - SIGTTIN/SIGTTOU are ignored in the shell to avoid being stopped when
@@ -30,6 +36,12 @@
 #include "jobs.h"
 #include "signals.h"
 #include "log.h"
+#include "server.h"
+#include "json.h"
+#include "outbuf.h"
+#include "prewarm.h"
+#include "lineread.h"
+#include "script.h"
 #include <sys/wait.h>
 #include <errno.h>
 #include <string.h>
@@ -44,12 +56,30 @@ static int kill_activity_cb(pid_t pid, const char *name, int stopped, void *ud){
     return 0;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
     prompt_init();
+    script_init_self(); // lets nested `shell.out file` runs skip exec
+
+    const char *serve_path = NULL;
+    int workers = SERVER_DEFAULT_WORKERS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) serve_path = argv[++i];
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0) json_set_default(1);
+    }
+    int script = script_arg_index(argv);
+    if (script > 0) return script_run_file(argv[script]);
+
     signals_init();
     log_init();
+    // Daemon mode: everything above is the warm state the workers inherit.
+    if (serve_path) return server_run(serve_path, workers);
+    prewarm_init();
 
-    char input[1024];
+    // Lines are read through lineread.c (not stdio), so the read builtin and
+    // the REPL share one view of stdin.
+    char *input = NULL;
+    size_t input_cap = 0, input_len = 0;
     // No custom SIGCHLD handler; rely on polling in jobs/executor.
 
     // Ensure the shell isn't stopped by the terminal when switching foreground pgid
@@ -74,19 +104,19 @@ int main(void) {
             struct timespec ts = {0, 50 * 1000 * 1000}; // 50ms
             nanosleep(&ts, NULL);
         }
+        out_flush_all(); // builtin/job output must precede the prompt
+        prewarm_idle(); // prefetch frequent executables while the user types
         prompt_print();
 
-        if (!fgets(input, sizeof(input), stdin)) {
-            if (feof(stdin)) {
-                // EOF (Ctrl-D): kill remaining jobs, print logout, exit 0
-                // Use \n; terminal will map to CRLF. Avoid writing \r\n directly to prevent \r\r\n on ONLCR ttys.
-                fputs("logout\n", stdout);
-                executor_for_each_activity(kill_activity_cb, NULL);
-                return 0;
-            }
-            if (ferror(stdin)) { clearerr(stdin); continue; }
-            continue; // defensive
+        int rc = lr_read_record(STDIN_FILENO, '\n', &input, &input_cap, &input_len);
+        if (rc == -1) {
+            // EOF (Ctrl-D): kill remaining jobs, print logout, exit 0
+            // Use \n; terminal will map to CRLF. Avoid writing \r\n directly to prevent \r\r\n on ONLCR ttys.
+            fputs("logout\n", stdout);
+            executor_for_each_activity(kill_activity_cb, NULL);
+            return 0;
         }
+        if (rc == -2) continue; // interrupted (Ctrl-C): fresh prompt
         // Immediately before executing the typed command, flush any job completion messages
         // so they appear before this command's output (expected by tests).
         executor_poll_background();
@@ -99,6 +129,7 @@ int main(void) {
         }
         // Store the entire shell_cmd in history (subject to rules)
         log_maybe_store_shell_cmd(input);
+        prewarm_learn(input);
         // Execute all command groups (executor handles builtins & background '&')
         (void)execute_first_cmd_group(input);
     }
@@ -0,0 +1,78 @@
+// mapfile.c: load lines into an indexed array
+// -------------------------------------------
+// Implements: mapfile [-t] [-d delim] [-n count] [-s skip] [name]
+//   mapfile lines < file      -> ${lines[0]}, ${lines[1]}, ... ${#lines[@]}
+//   mapfile -t lines < file   -> same, without the trailing newlines
+//   mapfile -s 1 -n 10 rows   -> skip one line, then keep the next ten
+// Without a name the array is MAPFILE. -d splits on another character.
+//
+// This is the bulk counterpart of `read` in a loop: the input is read in a
+// few large blocks (lineread.c, the whole rest of a regular file in one
+// read), then split in a single memchr() pass that only records offsets. The
+// array keeps that one buffer and one offsets table (vars.c), so the cost
+// does not grow with one allocation per line. With -n, nothing past the last
+// wanted line is consumed.
+#include "mapfile.h"
+#include "lineread.h"
+#include "vars.h"
+#include "outbuf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int parse_count(const char *s, size_t *out){
+    if (!*s) return 0;
+    size_t v = 0;
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9') return 0;
+        v = v * 10 + (size_t)(*s - '0');
+    }
+    *out = v;
+    return 1;
+}
+
+int run_mapfile_argv(int argc, char **argv){
+    int trim = 0, delim = '\n';
+    size_t max = 0, skip = 0;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        const char *a = argv[i];
+        int ok = 1;
+        if (strcmp(a, "-t") == 0) trim = 1;
+        else if (strcmp(a, "-d") == 0 && i + 1 < argc) delim = (unsigned char)argv[++i][0];
+        else if (strcmp(a, "-n") == 0 && i + 1 < argc) ok = parse_count(argv[++i], &max);
+        else if (strcmp(a, "-s") == 0 && i + 1 < argc) ok = parse_count(argv[++i], &skip);
+        else ok = 0;
+        if (!ok) { out_puts(out_stdout(), "mapfile: Invalid Syntax!"); return 1; }
+    }
+    const char *name = i < argc ? argv[i] : "MAPFILE";
+    if (i + 1 < argc || !vars_valid_name(name)) {
+        out_puts(out_stdout(), "mapfile: Invalid Syntax!");
+        return 1;
+    }
+    out_flush_all();
+
+    char *data = NULL;
+    size_t cap = 0, len = 0;
+    int rc = lr_read_bulk(STDIN_FILENO, delim, max ? max + skip : 0, &data, &cap, &len);
+
+    // One pass over the buffer: each memchr() hit ends a record.
+    size_t *offs = NULL, count = 0, ocap = 0, pos = 0;
+    while (pos < len) {
+        const char *hit = memchr(data + pos, delim, len - pos);
+        size_t end = hit ? (size_t)(hit - data) + 1 : len;
+        if (skip) { skip--; pos = end; continue; }
+        if (count + 2 > ocap) {
+            ocap = ocap ? ocap * 2 : 1024;
+            size_t *no = realloc(offs, ocap * sizeof(*offs));
+            if (!no) { free(offs); free(data); return 1; }
+            offs = no;
+        }
+        offs[count++] = pos;
+        pos = end;
+    }
+    if (!offs && !(offs = malloc(sizeof(*offs)))) { free(data); return 1; }
+    offs[count] = len;
+    vars_set_array(name, data, offs, count, trim ? delim : -1);
+    return rc == 0 ? 0 : 1;
+}
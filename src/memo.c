@@ -0,0 +1,435 @@
+// memo.c: cache the results of deterministic commands
+// ---------------------------------------------------
+// Implements: memo [--dep file]... [--env VAR]... command [args...]
+// Examples:
+//   memo --dep schema.sql ./gen_models    -> rerun only when schema.sql changes
+//   memo --env TARGET make -s print-vars  -> TARGET becomes part of the key
+//
+// A cache key is built from:
+//   - every argv word
+//   - the current directory
+//   - PATH, LANG, LC_ALL and every --env variable (name and value)
+//   - for every --dep file: device, inode, size and mtime (or "missing")
+// The key is hashed (64-bit FNV-1a) and names a directory under
+// $HOME/.myshell_memo holding four files: key (the full key, compared on
+// lookup so a hash collision is never replayed), out, err and status.
+//
+// Hit: out/err are copied to our stdout/stderr and the status is returned.
+// Miss: the command runs with its stdout/stderr on pipes; we copy everything
+// to our own stdout/stderr and into a temporary entry, which is renamed into
+// place once the command exits. Commands killed by a signal or not found are
+// not cached. On a terminal the command runs in its own process group like a
+// pipeline; Ctrl-Z makes it a stopped job (not cached) whose output is still
+// copied through once it is resumed.
+//
+// The cache is bounded by MEMO_MAX_BYTES. A hit touches the entry's mtime, so
+// evicting the oldest mtimes first is LRU. stdin is not part of the key.
+#define _POSIX_C_SOURCE 200809L
+#include "memo.h"
+#include "jobs.h"
+#include "outbuf.h"
+#include "prewarm.h"
+#include "signals.h"
+#include "statcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <linux/limits.h> // for PATH_MAX
+
+#define MEMO_MAX_BYTES (64L * 1024 * 1024) // total size of all cached output
+#define MEMO_MAX_DEPS 32
+#define MEMO_MAX_ENVS 32
+#define MEMO_STOP_POLL_MS 100 // how often a silent command is checked for Ctrl-Z
+
+static const char *memo_default_env[] = { "PATH", "LANG", "LC_ALL" };
+static const char *entry_files[] = { "key", "out", "err", "status" };
+
+typedef struct {
+    char *s;
+    size_t len, cap;
+} KeyBuf;
+
+static void key_add(KeyBuf *k, const char *s, size_t n){
+    if (k->len + n + 1 > k->cap) {
+        size_t ncap = k->cap ? k->cap * 2 : 256;
+        while (ncap < k->len + n + 1) ncap *= 2;
+        char *ns = realloc(k->s, ncap);
+        if (!ns) return;
+        k->s = ns; k->cap = ncap;
+    }
+    memcpy(k->s + k->len, s, n);
+    k->len += n;
+    k->s[k->len] = '\0';
+}
+
+// Length-prefixed field: "tag len:value\n" keeps the key unambiguous.
+static void key_field(KeyBuf *k, const char *tag, const char *value){
+    char head[64];
+    size_t n = strlen(value);
+    int h = snprintf(head, sizeof(head), "%s %zu:", tag, n);
+    key_add(k, head, (size_t)h);
+    key_add(k, value, n);
+    key_add(k, "\n", 1);
+}
+
+static uint64_t fnv1a64(const char *s, size_t n){
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; i++) { h ^= (unsigned char)s[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+static int open_cache_dir(void){
+    const char *home = getenv("HOME");
+    if (!home) home = ".";
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/.myshell_memo", home);
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+    return open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+// Read a whole small file relative to dirfd. Caller frees.
+static char *read_file_at(int dirfd, const char *name, size_t *len_out){
+    int fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return NULL; }
+    size_t len = (size_t)st.st_size;
+    char *buf = malloc(len + 1);
+    size_t got = 0;
+    while (buf && got < len) {
+        ssize_t r = read(fd, buf + got, len - got);
+        if (r <= 0) break;
+        got += (size_t)r;
+    }
+    close(fd);
+    if (!buf || got != len) { free(buf); return NULL; }
+    buf[len] = '\0';
+    *len_out = len;
+    return buf;
+}
+
+static int write_all(int fd, const char *s, size_t n){
+    while (n > 0) {
+        ssize_t w = write(fd, s, n);
+        if (w < 0) { if (errno == EINTR) continue; return -1; }
+        s += w; n -= (size_t)w;
+    }
+    return 0;
+}
+
+static void copy_to(int dirfd, const char *name, OutBuf *o){
+    int fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    char buf[65536];
+    ssize_t r;
+    while ((r = read(fd, buf, sizeof(buf))) > 0) out_write(o, buf, (size_t)r);
+    close(fd);
+    out_flush(o);
+}
+
+static void remove_entry(int cachefd, const char *name){
+    int fd = openat(cachefd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        for (size_t i = 0; i < sizeof(entry_files) / sizeof(entry_files[0]); i++)
+            unlinkat(fd, entry_files[i], 0);
+        close(fd);
+    }
+    unlinkat(cachefd, name, AT_REMOVEDIR);
+}
+
+// Replay a cached entry. Returns the stored status, or -1 on a miss.
+static int try_replay(int cachefd, const char *name, const KeyBuf *key){
+    int fd = openat(cachefd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    size_t klen = 0, slen = 0;
+    char *stored = read_file_at(fd, "key", &klen);
+    char *status = read_file_at(fd, "status", &slen);
+    int rc = -1;
+    if (stored && status && klen == key->len && memcmp(stored, key->s, klen) == 0) {
+        copy_to(fd, "out", out_stdout());
+        copy_to(fd, "err", out_stderr());
+        rc = atoi(status);
+        futimens(fd, NULL); // most recently used
+    }
+    free(stored);
+    free(status);
+    close(fd);
+    return rc;
+}
+
+typedef struct {
+    char name[32];
+    time_t mtime;
+    off_t size;
+} CacheEntry;
+
+static int by_mtime(const void *a, const void *b){
+    const CacheEntry *x = a, *y = b;
+    return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+// Drop least recently used entries until the cache fits MEMO_MAX_BYTES.
+static void evict(int cachefd){
+    int fd = dup(cachefd);
+    DIR *d = fd >= 0 ? fdopendir(fd) : NULL;
+    if (!d) { if (fd >= 0) close(fd); return; }
+    CacheEntry *ents = NULL;
+    size_t n = 0, cap = 0;
+    off_t total = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        // Skip . and .. and in-progress "<key>.tmp.<pid>" entries.
+        if (strchr(de->d_name, '.') || strlen(de->d_name) >= sizeof(ents[0].name)) continue;
+        int efd = openat(cachefd, de->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (efd < 0) continue;
+        struct stat st;
+        if (n == cap) {
+            size_t ncap = cap ? cap * 2 : 64;
+            CacheEntry *ne = realloc(ents, ncap * sizeof(*ne));
+            if (!ne) { close(efd); break; }
+            ents = ne; cap = ncap;
+        }
+        CacheEntry *e = &ents[n];
+        strcpy(e->name, de->d_name);
+        e->size = 0;
+        e->mtime = fstat(efd, &st) == 0 ? st.st_mtime : 0;
+        for (size_t i = 0; i < sizeof(entry_files) / sizeof(entry_files[0]); i++)
+            if (fstatat(efd, entry_files[i], &st, 0) == 0) e->size += st.st_size;
+        close(efd);
+        total += e->size;
+        n++;
+    }
+    closedir(d);
+    if (total > MEMO_MAX_BYTES) {
+        qsort(ents, n, sizeof(*ents), by_mtime);
+        for (size_t i = 0; i < n && total > MEMO_MAX_BYTES; i++) {
+            remove_entry(cachefd, ents[i].name);
+            total -= ents[i].size;
+        }
+    }
+    free(ents);
+}
+
+// Copy the pipes in fds[] to our stdout/stderr and to files[] (-1 = don't
+// record; cleared on a write error) until both reach EOF. With watch > 0
+// the child is checked for Ctrl-Z on the way: returns 1 as soon as it is
+// stopped, leaving the rest to the caller; returns 0 at EOF. *exited is set
+// (with *st) once watch was reaped here.
+static int tee_pipes(int fds[2], int files[2], pid_t watch, int *st, int *exited){
+    struct pollfd pfd[2] = { { fds[0], POLLIN, 0 }, { fds[1], POLLIN, 0 } };
+    OutBuf *dest[2] = { out_stdout(), out_stderr() };
+    int open_pipes = (fds[0] >= 0) + (fds[1] >= 0);
+    char buf[65536];
+    while (open_pipes > 0) {
+        int n = poll(pfd, 2, watch > 0 && !*exited ? MEMO_STOP_POLL_MS : -1);
+        if (n < 0) { if (errno == EINTR) continue; break; }
+        if (watch > 0 && !*exited) {
+            pid_t w = waitpid(watch, st, WNOHANG | WUNTRACED);
+            if (w == watch && WIFSTOPPED(*st)) return 1;
+            if (w == watch) *exited = 1; // keep draining: descendants may still write
+        }
+        for (int i = 0; i < 2; i++) {
+            if (pfd[i].fd < 0 || !pfd[i].revents) continue;
+            ssize_t r = read(pfd[i].fd, buf, sizeof(buf));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) { close(pfd[i].fd); pfd[i].fd = fds[i] = -1; open_pipes--; continue; }
+            out_write(dest[i], buf, (size_t)r);
+            out_flush(dest[i]);
+            if (files[i] >= 0 && write_all(files[i], buf, (size_t)r) != 0) { close(files[i]); files[i] = -1; }
+        }
+    }
+    return 0;
+}
+
+// The command was stopped with Ctrl-Z: like run_pipeline, make it a stopped
+// background job. A helper joins its process group and keeps copying the
+// pipes (without recording) so the output still arrives after fg or bg.
+static int stop_to_background(pid_t pid, const char *name, int fds[2]){
+    pid_t pids[2] = { pid, -1 };
+    out_flush_all();
+    pid_t helper = fork();
+    if (helper == 0) {
+        setpgid(0, pid);
+        signals_reset_for_child();
+        int none[2] = { -1, -1 }, st = 0, exited = 0;
+        tee_pipes(fds, none, -1, &st, &exited);
+        out_flush_all();
+        _exit(0);
+    }
+    if (helper > 0) { setpgid(helper, pid); pids[1] = helper; }
+    for (int i = 0; i < 2; i++) if (fds[i] >= 0) close(fds[i]);
+    jobs_set_foreground(pid, pids, helper > 0 ? 2 : 1, name);
+    int jobnum = jobs_move_foreground_to_background_stopped();
+    jobs_take_terminal();
+    jobs_clear_foreground();
+    if (jobnum != -1) out_printf(out_stdout(), "[%d] Stopped %s\n", jobnum, name);
+    out_flush(out_stdout());
+    return 148; // as run_pipeline does for a stopped foreground job
+}
+
+// Run argv, copying its stdout/stderr to ours and to the temporary entry
+// at tmpfd (-1 = don't record). Returns the shell status of the command and
+// sets *cacheable. When the shell owns the terminal the command gets its own
+// process group and the terminal, like a pipeline, so Ctrl-C/Ctrl-Z reach
+// it and not the shell.
+static int run_and_tee(char **argv, int tmpfd, int *cacheable){
+    int outp[2], errp[2];
+    *cacheable = 0;
+    if (pipe(outp) != 0) return 1;
+    if (pipe(errp) != 0) { close(outp[0]); close(outp[1]); return 1; }
+    const char *exe = prewarm_resolve(argv[0]);
+    int own_tty = jobs_terminal_control() && isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+    out_flush_all();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(outp[0]); close(outp[1]); close(errp[0]); close(errp[1]);
+        return 1;
+    }
+    if (pid == 0) {
+        if (own_tty) setpgid(0, 0);
+        signals_reset_for_child();
+        dup2(outp[1], STDOUT_FILENO);
+        dup2(errp[1], STDERR_FILENO);
+        close(outp[0]); close(outp[1]); close(errp[0]); close(errp[1]);
+        if (exe) execv(exe, argv);
+        execvp(argv[0], argv);
+        fputs("Command not found!\n", stderr);
+        _exit(127);
+    }
+    close(outp[1]);
+    close(errp[1]);
+    if (own_tty) {
+        setpgid(pid, pid);
+        jobs_set_foreground(pid, &pid, 1, argv[0]);
+        jobs_give_terminal(pid);
+    }
+
+    int files[2] = { -1, -1 };
+    if (tmpfd >= 0) {
+        files[0] = openat(tmpfd, "out", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        files[1] = openat(tmpfd, "err", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    }
+    int record_ok = files[0] >= 0 && files[1] >= 0;
+    int fds[2] = { outp[0], errp[0] };
+    int st = 0, exited = 0;
+    if (tee_pipes(fds, files, own_tty ? pid : -1, &st, &exited)) {
+        for (int i = 0; i < 2; i++) if (files[i] >= 0) close(files[i]);
+        return stop_to_background(pid, argv[0], fds);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+        if (files[i] < 0 || close(files[i]) != 0) record_ok = 0;
+    }
+
+    while (!exited) {
+        pid_t w = waitpid(pid, &st, own_tty ? WUNTRACED : 0);
+        if (w < 0 && errno != EINTR) break;
+        if (w < 0) continue;
+        if (WIFSTOPPED(st)) { // stopped after closing its output
+            int none[2] = { -1, -1 };
+            return stop_to_background(pid, argv[0], none);
+        }
+        exited = 1;
+    }
+    if (own_tty) {
+        jobs_take_terminal();
+        jobs_clear_foreground();
+    }
+    if (!exited) return 1;
+    if (WIFSIGNALED(st)) return 128 + WTERMSIG(st);
+    int code = WEXITSTATUS(st);
+    *cacheable = record_ok && code != 126 && code != 127;
+    return code;
+}
+
+int run_memo_argv(int argc, char **argv){
+    const char *deps[MEMO_MAX_DEPS];
+    const char *envs[MEMO_MAX_ENVS];
+    int ndeps = 0, nenvs = 0;
+    int i = 1;
+    while (i < argc) {
+        if (strcmp(argv[i], "--dep") == 0 && i + 1 < argc && ndeps < MEMO_MAX_DEPS) deps[ndeps++] = argv[i + 1];
+        else if (strcmp(argv[i], "--env") == 0 && i + 1 < argc && nenvs < MEMO_MAX_ENVS) envs[nenvs++] = argv[i + 1];
+        else break;
+        i += 2;
+    }
+    if (i >= argc || argv[i][0] == '-') {
+        out_puts(out_stdout(), "memo: Invalid Syntax!");
+        return 1;
+    }
+    char **cmd = &argv[i];
+
+    KeyBuf key = { 0 };
+    for (char **a = cmd; *a; a++) key_field(&key, "arg", *a);
+    char cwd[PATH_MAX];
+    key_field(&key, "cwd", getcwd(cwd, sizeof(cwd)) ? cwd : "?");
+    int ndefault = (int)(sizeof(memo_default_env) / sizeof(memo_default_env[0]));
+    for (int e = 0; e < ndefault + nenvs; e++) {
+        const char *name = e < ndefault ? memo_default_env[e] : envs[e - ndefault];
+        const char *val = getenv(name);
+        key_field(&key, "env", name);
+        key_field(&key, "val", val ? val : "\x01unset");
+    }
+    for (int d = 0; d < ndeps; d++) {
+        struct stat st;
+        char info[128];
+        if (statcache_stat(AT_FDCWD, deps[d], &st, 0) == 0)
+            snprintf(info, sizeof(info), "%llu %llu %lld %lld.%09ld",
+                     (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                     (long long)st.st_size, (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+        else
+            snprintf(info, sizeof(info), "missing");
+        key_field(&key, "dep", deps[d]);
+        key_field(&key, "stat", info);
+    }
+    if (!key.s) return 1;
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)fnv1a64(key.s, key.len));
+    int cachefd = open_cache_dir();
+    if (cachefd >= 0) {
+        int rc = try_replay(cachefd, name, &key);
+        if (rc >= 0) { close(cachefd); free(key.s); return rc; }
+    }
+
+    // Miss: record into "<name>.tmp.<pid>" and rename into place at the end.
+    char tmpname[64];
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp.%ld", name, (long)getpid());
+    int tmpfd = -1;
+    if (cachefd >= 0 && mkdirat(cachefd, tmpname, 0700) == 0)
+        tmpfd = openat(cachefd, tmpname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int cacheable = 0;
+    int rc = run_and_tee(cmd, tmpfd, &cacheable);
+    statcache_invalidate(); // the command and our cache entry changed files
+    if (tmpfd >= 0) {
+        char status[16];
+        int slen = snprintf(status, sizeof(status), "%d\n", rc);
+        int kfd = cacheable ? openat(tmpfd, "key", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600) : -1;
+        int sfd = cacheable ? openat(tmpfd, "status", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600) : -1;
+        if (kfd < 0 || sfd < 0 || write_all(kfd, key.s, key.len) != 0 || write_all(sfd, status, (size_t)slen) != 0)
+            cacheable = 0;
+        if (kfd >= 0) close(kfd);
+        if (sfd >= 0) close(sfd);
+        close(tmpfd);
+        if (cacheable) {
+            remove_entry(cachefd, name); // stale entry whose key didn't match
+            if (renameat(cachefd, tmpname, cachefd, name) != 0) cacheable = 0;
+        }
+        if (!cacheable) remove_entry(cachefd, tmpname);
+        else evict(cachefd);
+    }
+    if (cachefd >= 0) close(cachefd);
+    free(key.s);
+    return rc;
+}
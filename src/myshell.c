@@ -0,0 +1,176 @@
+// myshell.c: embeddable shell library (libmyshell)
+// ------------------------------------------------
+// Lets a host C program run command lines in-process instead of popen()ing the
+// shell binary. The same modules as the interactive shell are used (parser,
+// executor, jobs, builtins); this file only adds a small context object around
+// them.
+//
+// How the context works:
+// - The modules keep their state in file-level globals (home directory in
+//   prompt.c, previous CWD in hop.c, the job table in jobs.c, the `last`
+//   capture in capture.c, shell variables in vars.c). A MyShell remembers its
+//   own copy of that session state and swaps it in on entry to every API call
+//   and back out on exit (activate/deactivate below). This keeps contexts
+//   independent, background jobs, job numbers and variables included, as
+//   long as calls are not made concurrently from several threads.
+// - Output capture: stdout/stderr are pointed at two anonymous temporary
+//   files while the line runs, then the files are read back and handed to the
+//   callback. Temporary files (instead of pipes) avoid deadlocking when a
+//   command writes more than a pipe buffer's worth of output.
+// - The host's signal dispositions are left alone (no signals_init()), and
+//   the terminal is never handed to a job: the host may not ignore SIGTTOU,
+//   and would be stopped taking it back.
+
+#include "myshell.h"
+#include "prompt.h"
+#include "parser.h"
+#include "executor.h"
+#include "hop.h"
+#include "log.h"
+#include "outbuf.h"
+#include "dirs.h"
+#include "jobs.h"
+#include "capture.h"
+#include "vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <linux/limits.h> // for PATH_MAX
+
+struct MyShell {
+    char *home;              // what '~' refers to
+    char cwd[PATH_MAX];      // session CWD, restored on every call
+    char prev[PATH_MAX];     // 'hop -' target ("" if none)
+    int flags;               // MYSHELL_* flags
+    JobTable *jobs;          // background jobs of this context
+    CaptureState capture;    // `last` setting and output of this context
+    VarTable *vars;          // shell variables of this context
+    char host_cwd[PATH_MAX]; // host CWD saved while the context is active
+};
+
+static int prompt_ready = 0;
+
+static void activate(MyShell *sh){
+    if (!getcwd(sh->host_cwd, sizeof(sh->host_cwd))) sh->host_cwd[0] = '\0';
+    prompt_set_home(sh->home);
+    jobs_table_swap(sh->jobs);
+    capture_swap(&sh->capture);
+    vars_table_swap(sh->vars);
+    hop_set_prev_cwd(sh->prev[0] ? sh->prev : NULL);
+    if (sh->cwd[0] && chdir(sh->cwd) != 0) {
+        // Session directory vanished: fall back to home like a fresh shell.
+        if (chdir(sh->home) != 0) { /* stay where the host is */ }
+    }
+    dirs_sync_cwd();
+}
+
+static void deactivate(MyShell *sh){
+    if (!getcwd(sh->cwd, sizeof(sh->cwd))) sh->cwd[0] = '\0';
+    const char *prev = hop_get_prev_cwd();
+    if (prev) { strncpy(sh->prev, prev, sizeof(sh->prev)); sh->prev[sizeof(sh->prev)-1] = '\0'; }
+    else sh->prev[0] = '\0';
+    jobs_table_swap(sh->jobs); // the context's jobs go back into sh->jobs
+    capture_swap(&sh->capture);
+    vars_table_swap(sh->vars);
+    if (sh->host_cwd[0] && chdir(sh->host_cwd) != 0) { /* nothing sensible to do */ }
+    dirs_sync_cwd();
+}
+
+MyShell *myshell_create(const char *home, int flags){
+    MyShell *sh = calloc(1, sizeof(*sh));
+    if (!sh) return NULL;
+    if (!prompt_ready) { prompt_init(); jobs_set_terminal_control(0); prompt_ready = 1; }
+    if (home) sh->home = strdup(home);
+    else sh->home = getcwd(NULL, 0);
+    sh->jobs = jobs_table_new();
+    sh->vars = vars_table_new();
+    if (!sh->home || !sh->jobs || !sh->vars) {
+        free(sh->home); free(sh->jobs); free(sh->vars); free(sh);
+        return NULL;
+    }
+    strncpy(sh->cwd, sh->home, sizeof(sh->cwd));
+    sh->cwd[sizeof(sh->cwd)-1] = '\0';
+    sh->flags = flags;
+    sh->capture.last_fd = -1;
+    if (flags & MYSHELL_HISTORY) log_init();
+    return sh;
+}
+
+// Read back a capture file from the start and pass it to the callback.
+static void replay_capture(FILE *fp, int fd, myshell_output_cb cb, void *ud){
+    char buf[8192];
+    size_t n;
+    rewind(fp);
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) cb(fd, buf, n, ud);
+}
+
+int myshell_exec(MyShell *sh, const char *line, myshell_output_cb cb, void *ud){
+    if (!sh || !line) return -1;
+    activate(sh);
+
+    FILE *cap_out = NULL, *cap_err = NULL;
+    int saved_out = -1, saved_err = -1;
+    if (cb) {
+        cap_out = tmpfile();
+        cap_err = tmpfile();
+        if (cap_out && cap_err) {
+            out_flush_all();
+            saved_out = dup(STDOUT_FILENO);
+            saved_err = dup(STDERR_FILENO);
+            dup2(fileno(cap_out), STDOUT_FILENO);
+            dup2(fileno(cap_err), STDERR_FILENO);
+        }
+    }
+
+    int status;
+    executor_poll_background();
+    if (!parse_command(line)) {
+        fputs("Invalid Syntax!\n", stdout);
+        status = -1;
+    } else {
+        if (sh->flags & MYSHELL_HISTORY) log_maybe_store_shell_cmd(line);
+        status = execute_first_cmd_group(line);
+    }
+
+    if (saved_out != -1) {
+        out_flush_all();
+        dup2(saved_out, STDOUT_FILENO); close(saved_out);
+        dup2(saved_err, STDERR_FILENO); close(saved_err);
+        replay_capture(cap_out, 1, cb, ud);
+        replay_capture(cap_err, 2, cb, ud);
+    }
+    if (cap_out) fclose(cap_out);
+    if (cap_err) fclose(cap_err);
+
+    deactivate(sh);
+    return status;
+}
+
+static int count_cb(pid_t pid, const char *name, int stopped, void *ud){
+    (void)pid; (void)name; (void)stopped;
+    (*(int*)ud)++;
+    return 0;
+}
+
+int myshell_poll_jobs(MyShell *sh){
+    if (!sh) return 0;
+    jobs_table_swap(sh->jobs);
+    executor_poll_background();
+    int n = 0;
+    executor_for_each_activity(count_cb, &n);
+    jobs_table_swap(sh->jobs);
+    return n;
+}
+
+void myshell_destroy(MyShell *sh){
+    if (!sh) return;
+    jobs_table_free(sh->jobs);
+    capture_swap(&sh->capture);
+    capture_reset();
+    capture_swap(&sh->capture);
+    vars_table_free(sh->vars);
+    free(sh->home);
+    free(sh);
+}
@@ -0,0 +1,135 @@
+// outbuf.c: buffered output for builtins
+// --------------------------------------
+// Builtins used to print with a mix of puts/printf/fputs. That has two
+// problems once fork() is involved:
+// - A builtin running in a forked pipeline stage ends with _exit(), which
+//   does not flush stdio, so output sitting in a stdio buffer is lost.
+// - Unflushed stdio data in the parent is copied into every child by fork()
+//   and can then be printed twice.
+// This module gives every output fd one explicit buffer. out_flush_all() is
+// called before every fork and before _exit(), which fixes both issues, and
+// large buffers mean a big `reveal` costs a handful of write() calls.
+//
+// Terminal vs pipe:
+// - For a terminal we keep at most TTY_CHUNK bytes pending so output
+//   appears promptly even from long-running builtins.
+// - For pipes and files we fill the whole buffer before writing.
+// - Payloads that don't fit are sent together with the pending bytes in a
+//   single writev() instead of being copied through the buffer.
+
+#include "outbuf.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+#define OUT_BUF_SZ 65536
+#define TTY_CHUNK 4096
+
+enum { MODE_UNKNOWN = 0, MODE_TTY, MODE_PIPE };
+
+struct OutBuf {
+    int fd;
+    int mode;     // MODE_*: detected lazily on first write after a flush_all
+    size_t len;   // bytes pending
+    char buf[OUT_BUF_SZ];
+};
+
+static OutBuf g_out = { STDOUT_FILENO, MODE_UNKNOWN, 0, {0} };
+static OutBuf g_err = { STDERR_FILENO, MODE_UNKNOWN, 0, {0} };
+
+OutBuf *out_stdout(void){ return &g_out; }
+OutBuf *out_stderr(void){ return &g_err; }
+
+static size_t limit_of(OutBuf *o){
+    if (o->mode == MODE_UNKNOWN) o->mode = isatty(o->fd) ? MODE_TTY : MODE_PIPE;
+    return o->mode == MODE_TTY ? TTY_CHUNK : OUT_BUF_SZ;
+}
+
+int out_is_tty(OutBuf *o){
+    limit_of(o);
+    return o->mode == MODE_TTY;
+}
+
+// Write pending bytes plus an optional extra payload with writev(), looping
+// over partial writes. On error (e.g. EPIPE) the data is dropped.
+static void write_out(OutBuf *o, const char *extra, size_t extra_len){
+    struct iovec iov[2];
+    int n = 0;
+    if (o->len) { iov[n].iov_base = o->buf; iov[n].iov_len = o->len; n++; }
+    if (extra_len) { iov[n].iov_base = (void*)extra; iov[n].iov_len = extra_len; n++; }
+    int first = 0;
+    while (first < n) {
+        ssize_t w = writev(o->fd, iov + first, n - first);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        size_t left = (size_t)w;
+        while (first < n && left >= iov[first].iov_len) { left -= iov[first].iov_len; first++; }
+        if (first < n) {
+            iov[first].iov_base = (char*)iov[first].iov_base + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    o->len = 0;
+}
+
+void out_flush(OutBuf *o){
+    if (o->len) write_out(o, NULL, 0);
+}
+
+void out_flush_all(void){
+    fflush(NULL);
+    out_flush(&g_out);
+    out_flush(&g_err);
+    g_out.mode = g_err.mode = MODE_UNKNOWN;
+}
+
+void out_write(OutBuf *o, const char *s, size_t n){
+    size_t limit = limit_of(o);
+    if (o->len + n <= limit) {
+        memcpy(o->buf + o->len, s, n);
+        o->len += n;
+        if (o->len == limit) out_flush(o);
+        return;
+    }
+    write_out(o, s, n);
+}
+
+void out_fputs(OutBuf *o, const char *s){ out_write(o, s, strlen(s)); }
+
+void out_puts(OutBuf *o, const char *s){
+    out_write(o, s, strlen(s));
+    out_putc(o, '\n');
+}
+
+void out_putc(OutBuf *o, char c){ out_write(o, &c, 1); }
+
+void out_printf(OutBuf *o, const char *fmt, ...){
+    char tmp[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n < sizeof(tmp)) { out_write(o, tmp, (size_t)n); return; }
+    // Rare long line: format straight into the buffer after making room.
+    out_flush(o);
+    if ((size_t)n < OUT_BUF_SZ) {
+        va_start(ap, fmt);
+        vsnprintf(o->buf, OUT_BUF_SZ, fmt, ap);
+        va_end(ap);
+        o->len = (size_t)n;
+        if (o->len >= limit_of(o)) out_flush(o);
+    } else { // longer than the buffer (e.g. a huge %s): format on the heap
+        char *big = malloc((size_t)n + 1);
+        if (!big) { out_write(o, tmp, sizeof(tmp) - 1); return; } // truncated
+        va_start(ap, fmt);
+        vsnprintf(big, (size_t)n + 1, fmt, ap);
+        va_end(ap);
+        out_write(o, big, (size_t)n);
+        free(big);
+    }
+}
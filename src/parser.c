@@ -1,5 +1,4 @@
 #include "parser.h"
-#include "parser.h"
 // Parser module
 // -------------
 // This validates user input against a very small shell grammar. It does not
@@ -15,164 +14,99 @@
 //   output     ->  ('>' | '>>') WS* name
 //   name       ->  [^|&><;\s]+  (we stop at whitespace or special characters)
 //
+// How it works:
+// - A lexer turns the line into tokens (name, '<', '>', '>>', '|', '&&',
+//   '&', ';', end), moving strictly forward: every byte is looked at once.
+// - The grammar above is checked by a small state machine over those tokens
+//   (what may come next after a name, a separator, a redirection, ...). There
+//   is no look-ahead over the text and no backtracking, so parsing time is
+//   linear in the line length whatever the input looks like (long runs of
+//   whitespace, thousands of ';' or redirections).
+// - The same pass can report the command name of every atomic command
+//   (parse_command_names), which history and prewarm use instead of
+//   scanning the line themselves.
+//
 // Notes:
-// - This is a hand-written, single-pass recursive-descent parser.
 // - We do not handle quotes or escapes to keep it beginner-friendly.
 // - The executor performs the real splitting later; this step just validates.
-#include <ctype.h>
-#include <string.h>
+#include <stddef.h>
 
-// grammar
-// shell_cmd  ->  cmd_group (( '&&' | '&' | ';') cmd_group)* ('&' | ';')?
-// cmd_group  ->  atomic ( '|' atomic )*
-// atomic     ->  name ( name | input | output )*
-// input      ->  '<' WS* name
-// output     ->  ('>' | '>>') WS* name
-// name       ->  [^|&><;]+ (trim trailing WS outside)
+typedef enum { T_NAME, T_IN, T_OUT, T_APPEND, T_PIPE, T_AND, T_AMP, T_SEMI, T_END } TokType;
 
 typedef struct {
     const char *s; // original string
     size_t i;      // current index
-} Parser;
-
-static void skip_ws(Parser *p) {
-    while (p->s[p->i] && (p->s[p->i] == ' ' || p->s[p->i] == '\t' || p->s[p->i] == '\n' || p->s[p->i] == '\r'))
-        p->i++;
-}
-
-// name -> one or more chars not in "|&><;". We do not trim here; caller should skip_ws around tokens.
-static int parse_name(Parser *p) {
-    size_t start = p->i;
-    while (p->s[p->i]) {
-        char c = p->s[p->i];
-        if (c == '|' || c == '&' || c == '>' || c == '<' || c == ';') break;
-        if (c == '\n' || c == '\r') break; // treat newline as separator/end
-        // For simplicity we treat whitespace as token separators; this avoids
-        // ambiguities and keeps the beginner grammar easy to reason about.
-        if (c == ' ' || c == '\t') break;
-        p->i++;
-    }
-    return p->i > start; // at least one char
-}
-
-// input -> '<' WS* name
-static int parse_input(Parser *p) {
-    size_t save = p->i;
-    if (p->s[p->i] != '<') return 0;
-    p->i++; // consume '<'
-    skip_ws(p);
-    if (!parse_name(p)) { p->i = save; return 0; }
-    return 1;
-}
+} Lexer;
 
-// output -> ('>' | '>>') WS* name
-static int parse_output(Parser *p) {
-    size_t save = p->i;
-    if (p->s[p->i] != '>') return 0;
-    p->i++; // consume '>'
-    if (p->s[p->i] == '>') {
-        p->i++; // '>>'
-    }
-    skip_ws(p);
-    if (!parse_name(p)) { p->i = save; return 0; }
-    return 1;
-}
+static int is_ws(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
 
-// atomic -> name ( name | input | output )*
-static int parse_atomic(Parser *p) {
-    skip_ws(p);
-    if (!parse_name(p)) return 0; // must start with a name
-    for (;;) {
-        size_t save = p->i;
-        skip_ws(p);
-        // try input/output first (they start with < or >)
-        if (parse_input(p)) continue;
-        if (parse_output(p)) continue;
-        // else try another name (argument)
-        if (parse_name(p)) continue;
-        // nothing more for atomic
-        p->i = save; // restore to position before WS skip for clean caller behavior
-        return 1;
-    }
+static int is_special(char c) {
+    return c == '|' || c == '&' || c == '>' || c == '<' || c == ';';
 }
 
-// cmd_group -> atomic ( '|' atomic )*
-static int parse_cmd_group(Parser *p) {
-    if (!parse_atomic(p)) return 0;
-    for (;;) {
-        size_t save = p->i;
-        skip_ws(p);
-        if (p->s[p->i] == '|') {
-            p->i++; // consume '|'
-            if (!parse_atomic(p)) { p->i = save; return 0; } // pipe must be followed by atomic
-            continue;
+// Next token; for T_NAME, *start/*len give the text.
+static TokType next_token(Lexer *lx, size_t *start, size_t *len) {
+    const char *s = lx->s;
+    while (is_ws(s[lx->i])) lx->i++;
+    char c = s[lx->i];
+    if (c == '\0') return T_END;
+    if (is_special(c)) {
+        lx->i++;
+        char d = s[lx->i];
+        switch (c) {
+        case '<': return T_IN;
+        case '>': if (d == '>') { lx->i++; return T_APPEND; } return T_OUT;
+        case '|': return T_PIPE;
+        case ';': return T_SEMI;
+        default:  if (d == '&') { lx->i++; return T_AND; } return T_AMP;
         }
-        p->i = save;
-        return 1;
     }
+    *start = lx->i;
+    while (s[lx->i] && !is_ws(s[lx->i]) && !is_special(s[lx->i])) lx->i++;
+    *len = lx->i - *start;
+    return T_NAME;
 }
 
-// shell_cmd  ->  cmd_group (( '&&' | '&' | ';') cmd_group)* ('&' | ';')?
-static int parse_shell_cmd(Parser *p) {
-    if (!parse_cmd_group(p)) return 0;
+// Where we are in the grammar, i.e. which tokens may come next.
+typedef enum {
+    S_COMMAND,   // start, or after '|' / '&&': an atomic must follow
+    S_ATOMIC,    // inside an atomic: more names, redirections, separators, end
+    S_REDIR,     // after '<', '>' or '>>': the file name must follow
+    S_SEPARATOR, // after ';' or '&': another cmd_group or the end
+} State;
+
+int parse_command_names(const char *s, parse_name_fn fn, void *ud) {
+    if (!s) return -1;
+    Lexer lx = { .s = s, .i = 0 };
+    State st = S_COMMAND;
     for (;;) {
-        size_t save = p->i;
-        skip_ws(p);
-        if (p->s[p->i] == ';') {
-            // Lookahead to allow a trailing ';' with no following cmd_group
-            size_t j = p->i + 1;
-            while (p->s[j] == ' ' || p->s[j] == '\t' || p->s[j] == '\n' || p->s[j] == '\r') j++;
-            if (p->s[j] == '\0') {
-                // trailing ';' — leave for optional trailer consumption
-                p->i = save;
-                break;
-            }
-            p->i++;
-            if (!parse_cmd_group(p)) { p->i = save; return 0; }
-            continue;
-        } else if (p->s[p->i] == '&') {
-            // Check for '&&' first (conditional AND)
-            if (p->s[p->i+1] == '&') {
-                size_t j = p->i + 2; // skip '&&'
-                while (p->s[j] == ' ' || p->s[j] == '\t' || p->s[j] == '\n' || p->s[j] == '\r') j++;
-                if (p->s[j] == '\0') { p->i = save; return 0; } // '&&' must be followed by a command
-                p->i += 2;
-                if (!parse_cmd_group(p)) { p->i = save; return 0; }
-                continue;
-            } else {
-                // Single '&' behaves like ';' but marks background; must be followed by a command unless trailing
-                size_t j = p->i + 1;
-                while (p->s[j] == ' ' || p->s[j] == '\t' || p->s[j] == '\n' || p->s[j] == '\r') j++;
-                if (p->s[j] == '\0') {
-                    // trailing &, let the optional handler consume it
-                    p->i = save;
-                    break;
-                }
-                p->i++;
-                if (!parse_cmd_group(p)) { p->i = save; return 0; }
-                continue;
+        size_t start = 0, len = 0;
+        TokType t = next_token(&lx, &start, &len);
+        switch (st) {
+        case S_COMMAND:
+        case S_SEPARATOR:
+            if (t == T_END && st == S_SEPARATOR) return 0; // trailing ';' or '&'
+            if (t != T_NAME) return -1;
+            if (fn) {
+                int rc = fn(s + start, len, ud);
+                if (rc) return rc;
             }
+            st = S_ATOMIC;
+            break;
+        case S_ATOMIC:
+            if (t == T_END) return 0;
+            if (t == T_IN || t == T_OUT || t == T_APPEND) st = S_REDIR;
+            else if (t == T_PIPE || t == T_AND) st = S_COMMAND;
+            else if (t == T_SEMI || t == T_AMP) st = S_SEPARATOR;
+            break; // T_NAME: another argument
+        case S_REDIR:
+            if (t != T_NAME) return -1;
+            st = S_ATOMIC;
+            break;
         }
-        p->i = save;
-        break;
-    }
-
-    // optional trailing & or ;
-    skip_ws(p);
-    if (p->s[p->i] == '&' || p->s[p->i] == ';') {
-        p->i++;
     }
-    skip_ws(p);
-    return 1;
 }
 
 int parse_command(const char *s) {
-    if (!s) return 0;
-    Parser p = { .s = s, .i = 0 };
-    int ok = parse_shell_cmd(&p);
-    if (!ok) return 0;
-    // after parse, ensure no trailing non-ws garbage like stray characters
-    skip_ws(&p);
-    // Accept if we are at end or at a single newline terminator.
-    return s[p.i] == '\0' || s[p.i] == '\n' || s[p.i] == '\r';
+    return parse_command_names(s, NULL, NULL) == 0;
 }
@@ -1,25 +1,44 @@
-// ping.c: send a signal to a process
+// ping.c: send a signal to processes
 // ----------------------------------
-// Implements: ping <pid> <signal_number>
+// Implements: ping [--wait] <target>... <signal>
+// Targets:
+//   1234     a process id
+//   %2       every live stage of job 2 (%, %% or %+ = most recent job)
+//   -1234    every process in process group 1234
+//   @pat     every process whose name (/proc/<pid>/comm) matches the
+//            shell-style pattern pat, e.g. @sleep or @worker-*
+// Signal: a number (taken modulo 32, like many student shells) or a name
+// such as TERM, SIGKILL or usr1.
 // Examples:
-//   ping 1234 9   -> send SIGKILL to process 1234
-//   ping 1234 19  -> send SIGSTOP (19 on many systems)
+//   ping 1234 9            -> send SIGKILL to process 1234
+//   ping %1 %2 @make* TERM -> terminate two jobs and all make processes
+//   ping --wait %3 INT     -> interrupt job 3 and block until it has exited
+//                             (Ctrl-C stops waiting)
 // Notes:
-// - We parse integers safely using strtol.
-// - If the process doesn't exist, we print "No such process found".
-// - Signal number is modulo 32 like many student shells (keeps values small).
+// - Delivery goes through pidfds (see procs.c): job stages get theirs when
+//   the job starts, other targets right after lookup, so a recycled pid is
+//   never signalled by mistake.
+// - If a target matches nothing, we print "No such process found".
+// - The shell never signals itself through a group or a name pattern.
 
 #include "ping.h"
+#include "jobs.h"
+#include "procs.h"
+#include "outbuf.h"
+#include "signals.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <signal.h>
 #include <errno.h>
-#include <ctype.h>
+#include <fnmatch.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <stdbool.h>
 
+#define MAX_JOB_STAGES 16
+
 static int parse_int(const char *s, long *out){
     if(!s||!*s) return 0;
     char *end=NULL;
@@ -30,33 +49,140 @@ static int parse_int(const char *s, long *out){
     *out=v; return 1;
 }
 
-int run_ping_argv(int argc, char **argv){
-    if(argc!=3){
-        puts("ping: Invalid Syntax!");
-        return 1;
+static const struct { const char *name; int sig; } signal_names[] = {
+    { "HUP", SIGHUP }, { "INT", SIGINT }, { "QUIT", SIGQUIT }, { "ILL", SIGILL },
+    { "TRAP", SIGTRAP }, { "ABRT", SIGABRT }, { "BUS", SIGBUS }, { "FPE", SIGFPE },
+    { "KILL", SIGKILL }, { "USR1", SIGUSR1 }, { "SEGV", SIGSEGV }, { "USR2", SIGUSR2 },
+    { "PIPE", SIGPIPE }, { "ALRM", SIGALRM }, { "TERM", SIGTERM }, { "CHLD", SIGCHLD },
+    { "CONT", SIGCONT }, { "STOP", SIGSTOP }, { "TSTP", SIGTSTP }, { "TTIN", SIGTTIN },
+    { "TTOU", SIGTTOU }, { "URG", SIGURG }, { "XCPU", SIGXCPU }, { "XFSZ", SIGXFSZ },
+    { "VTALRM", SIGVTALRM }, { "PROF", SIGPROF }, { "SYS", SIGSYS },
+};
+
+// Number (modulo 32) or case-insensitive name with optional SIG prefix.
+static int parse_signal(const char *s, int *out){
+    long v;
+    if(parse_int(s, &v)){ *out = (int)(v % 32); return 1; }
+    if(strncasecmp(s, "SIG", 3)==0) s += 3;
+    for(size_t i=0;i<sizeof(signal_names)/sizeof(signal_names[0]);i++){
+        if(strcasecmp(s, signal_names[i].name)==0){ *out = signal_names[i].sig; return 1; }
+    }
+    return 0;
+}
+
+// Resolved targets: pid plus pidfd, and whether we opened the pidfd
+// ourselves (job pidfds belong to the job table).
+typedef struct {
+    pid_t *pids;
+    int *pidfds;
+    char *owned;
+    int len, cap;
+} TargetList;
+
+static int add_target(TargetList *t, pid_t pid, int pidfd, int owned){
+    if(t->len == t->cap){
+        int ncap = t->cap ? t->cap*2 : 16;
+        pid_t *np = realloc(t->pids, (size_t)ncap*sizeof(pid_t));
+        if(np) t->pids = np;
+        int *nf = realloc(t->pidfds, (size_t)ncap*sizeof(int));
+        if(nf) t->pidfds = nf;
+        char *no = realloc(t->owned, (size_t)ncap);
+        if(no) t->owned = no;
+        if(!np || !nf || !no){ if(owned && pidfd>=0) close(pidfd); return 0; }
+        t->cap = ncap;
+    }
+    t->pids[t->len] = pid;
+    t->pidfds[t->len] = pidfd;
+    t->owned[t->len] = (char)owned;
+    t->len++;
+    return 1;
+}
+
+static void free_targets(TargetList *t){
+    for(int i=0;i<t->len;i++) if(t->owned[i] && t->pidfds[i]>=0) close(t->pidfds[i]);
+    free(t->pids); free(t->pidfds); free(t->owned);
+}
+
+// Add every process selected by one target argument. Returns the number of
+// processes added (0 = nothing matched).
+static int resolve_target(const char *arg, TargetList *t){
+    int before = t->len;
+    if(arg[0]=='%'){
+        long jobnum = 0;
+        const char *spec = arg+1;
+        if(*spec && strcmp(spec,"%")!=0 && strcmp(spec,"+")!=0 && (!parse_int(spec,&jobnum) || jobnum<=0)) return 0;
+        pid_t pids[MAX_JOB_STAGES]; int fds[MAX_JOB_STAGES];
+        int n = jobs_job_targets((int)jobnum, pids, fds, MAX_JOB_STAGES);
+        for(int i=0;i<n;i++) add_target(t, pids[i], fds[i], 0);
+        return t->len - before;
+    }
+    if(arg[0]=='-' || arg[0]=='@'){
+        long pgid = 0;
+        if(arg[0]=='-' && (!parse_int(arg+1,&pgid) || pgid<=0)) return 0;
+        const ProcInfo *procs;
+        int n = procs_scan(&procs);
+        pid_t self = getpid();
+        for(int i=0;i<n;i++){
+            if(procs[i].pid==self) continue;
+            int match = arg[0]=='-' ? procs[i].pgid==(pid_t)pgid
+                                    : fnmatch(arg+1, procs[i].comm, 0)==0;
+            if(!match) continue;
+            int fd = procs_pidfd_open(procs[i].pid);
+            if(fd<0 && errno==ESRCH) continue; // exited since the scan
+            add_target(t, procs[i].pid, fd, 1);
+        }
+        return t->len - before;
     }
-    long pid_l=0, sig_l=0;
-    if(!parse_int(argv[1], &pid_l) || pid_l<=0){
-        puts("No such process found");
+    long pid = 0;
+    if(!parse_int(arg,&pid) || pid<=0) return 0;
+    int fd = procs_pidfd_open((pid_t)pid);
+    if(fd<0 && errno==ESRCH) return 0;
+    add_target(t, (pid_t)pid, fd, 1);
+    return t->len - before;
+}
+
+int run_ping_argv(int argc, char **argv){
+    int wait_exit = 0;
+    int first = 1;
+    if(argc>1 && strcmp(argv[1], "--wait")==0){ wait_exit = 1; first = 2; }
+    if(argc-first < 2){
+        out_puts(out_stdout(), "ping: Invalid Syntax!");
         return 1;
     }
-    if(!parse_int(argv[2], &sig_l)){
-        puts("ping: Invalid Syntax!");
+    const char *sig_arg = argv[argc-1];
+    int sig = 0;
+    if(!parse_signal(sig_arg, &sig)){
+        out_puts(out_stdout(), "ping: Invalid Syntax!");
         return 1;
     }
-    int actual = (int)(sig_l % 32);
-    if(actual==0) actual = 0; // signal 0 just error-checks permission/existence
-    int rc = kill((pid_t)pid_l, actual);
-    if(rc!=0){
-        if(errno==ESRCH){
-            puts("No such process found");
-        } else {
-            perror("kill");
+
+    TargetList t = {0};
+    int rc = 0;
+    for(int i=first;i<argc-1;i++){
+        int start = t.len;
+        if(resolve_target(argv[i], &t)==0){
+            out_puts(out_stdout(), "No such process found");
+            rc = 1;
+            continue;
+        }
+        for(int k=start;k<t.len;k++){
+            if(procs_send(t.pids[k], t.pidfds[k], sig)!=0){
+                if(errno==ESRCH) out_puts(out_stdout(), "No such process found");
+                else out_printf(out_stdout(), "ping: %d: %s\n", (int)t.pids[k], strerror(errno));
+                rc = 1;
+                continue;
+            }
+            out_printf(out_stdout(), "Sent signal %s to process with pid %d\n", sig_arg, (int)t.pids[k]);
         }
-        return 1;
     }
-    printf("Sent signal %ld to process with pid %ld\n", sig_l, pid_l);
-    return 0;
+    procs_invalidate();
+    if(wait_exit){
+        out_flush(out_stdout());
+        signals_take_interrupt(); // forget a Ctrl-C typed before this command
+        if(procs_wait(t.pidfds, t.len)<0) rc = 1;
+    }
+    free_targets(&t);
+    return rc;
 }
 
 bool try_handle_ping(const char *line){
@@ -0,0 +1,231 @@
+// prewarm.c: make the next exec cheaper
+// -------------------------------------
+// Two costs show up between pressing Enter and a program starting:
+// 1) execvp() walks every $PATH directory in the child, every time.
+// 2) The first run of a large binary waits for its pages to come off disk.
+//
+// For (1) we keep a small hash table name -> full path, filled in the parent
+// on first use and dropped when $PATH changes; the child calls execv() with
+// the cached path (and still falls back to execvp() if that fails).
+//
+// For (2) we count how often each command found on PATH is run (persisted in
+// $HOME/.myshell_prewarm so the counts survive restarts; when the table fills
+// up, all counts are halved and the ones reaching zero dropped) and, while
+// the shell sits idle at an interactive prompt, call posix_fadvise(WILLNEED)
+// on the most used executables. WILLNEED only queues readahead, so it returns immediately
+// and the disk reads overlap with the user typing.
+#define _POSIX_C_SOURCE 200809L
+#include "prewarm.h"
+#include "executor.h"
+#include "parser.h"
+#include "statcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <linux/limits.h> // for PATH_MAX
+
+#define PREWARM_SLOTS 256       // hash table size (power of two)
+#define PREWARM_NAME_MAX 64     // longer command names are not tracked
+#define PREWARM_TOP 8           // executables warmed per idle prompt
+#define PREWARM_INTERVAL 300    // seconds before the same file is warmed again
+
+typedef struct {
+    char name[PREWARM_NAME_MAX]; // "" = empty slot
+    unsigned count;              // how often the command was run
+    int resolved;                // PATH lookup done (path may still be NULL)
+    char *path;                  // full path, NULL if not in PATH
+    time_t warmed;               // last posix_fadvise() for this entry
+} Entry;
+
+static Entry table[PREWARM_SLOTS];
+static int used = 0;
+static int dirty = 0;            // counts changed since the last save
+static char *cached_path_env = NULL;
+static char counts_path[512];
+
+static unsigned hash_name(const char *s){
+    unsigned h = 2166136261u; // FNV-1a
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+// The slot holding name, or the empty slot where it would go.
+static Entry *probe(const char *name){
+    unsigned i = hash_name(name) & (PREWARM_SLOTS - 1);
+    while (table[i].name[0] && strcmp(table[i].name, name) != 0)
+        i = (i + 1) & (PREWARM_SLOTS - 1);
+    return &table[i]; // never full: used stays below PREWARM_SLOTS
+}
+
+// Make room: halve every count and drop the entries that reach zero, so
+// names run once long ago (one-off tools, renamed binaries) give way to new
+// ones instead of filling the table for good.
+static void age_counts(void){
+    static Entry old[PREWARM_SLOTS];
+    while (used >= PREWARM_SLOTS * 3 / 4) {
+        memcpy(old, table, sizeof(table));
+        memset(table, 0, sizeof(table));
+        used = 0;
+        for (int i = 0; i < PREWARM_SLOTS; i++) {
+            if (!old[i].name[0]) continue;
+            if (old[i].count / 2 == 0) { free(old[i].path); continue; }
+            Entry *e = probe(old[i].name);
+            *e = old[i];
+            e->count /= 2;
+            used++;
+        }
+    }
+    dirty = 1;
+}
+
+// Find the slot for name, inserting it if create is set (aging the counts
+// first when the table is full). NULL if the name is too long.
+static Entry *lookup(const char *name, int create){
+    if (strlen(name) >= PREWARM_NAME_MAX) return NULL;
+    Entry *e = probe(name);
+    if (e->name[0]) return e;
+    if (!create) return NULL;
+    if (used >= PREWARM_SLOTS * 3 / 4) {
+        age_counts();
+        e = probe(name);
+    }
+    strcpy(e->name, name);
+    used++;
+    return e;
+}
+
+// Forget all resolved paths if $PATH is not what they were resolved against.
+static void check_path_env(void){
+    const char *env = getenv("PATH");
+    if (!env) env = "";
+    if (cached_path_env && strcmp(cached_path_env, env) == 0) return;
+    for (int i = 0; i < PREWARM_SLOTS; i++) {
+        free(table[i].path);
+        table[i].path = NULL;
+        table[i].resolved = 0;
+        table[i].warmed = 0;
+    }
+    free(cached_path_env);
+    cached_path_env = strdup(env);
+}
+
+static char *search_path(const char *name){
+    const char *p = cached_path_env ? cached_path_env : "";
+    char full[PATH_MAX];
+    while (1) {
+        const char *colon = strchr(p, ':');
+        size_t len = colon ? (size_t)(colon - p) : strlen(p);
+        // An empty PATH element means the current directory; don't cache that.
+        if (len > 0 && len + strlen(name) + 2 <= sizeof(full)) {
+            memcpy(full, p, len);
+            full[len] = '/';
+            strcpy(full + len + 1, name);
+            struct stat st;
+            if (statcache_stat(AT_FDCWD, full, &st, 0) == 0 && S_ISREG(st.st_mode) && access(full, X_OK) == 0)
+                return strdup(full);
+        }
+        if (!colon) return NULL;
+        p = colon + 1;
+    }
+}
+
+const char *prewarm_resolve(const char *name){
+    if (!name || !*name || strchr(name, '/')) return NULL;
+    check_path_env();
+    Entry *e = lookup(name, 0);
+    if (e && e->resolved) return e->path;
+    // Only names found on PATH get a slot: typos and missing commands would
+    // otherwise crowd out the real ones.
+    char *path = search_path(name);
+    if (!e && path) e = lookup(name, 1);
+    if (!e) { free(path); return NULL; }
+    e->path = path;
+    e->resolved = 1;
+    return e->path;
+}
+
+void prewarm_init(void){
+    const char *home = getenv("HOME");
+    if (!home) home = ".";
+    snprintf(counts_path, sizeof(counts_path), "%s/.myshell_prewarm", home);
+    FILE *fp = fopen(counts_path, "r");
+    if (!fp) return;
+    char name[PREWARM_NAME_MAX];
+    unsigned count;
+    // One "count name" pair per line.
+    while (fscanf(fp, "%u %63s", &count, name) == 2) {
+        Entry *e = lookup(name, 1);
+        if (e) e->count = count;
+    }
+    fclose(fp);
+}
+
+// Count one command name (not NUL-terminated) reported by the parser.
+static int learn_name(const char *start, size_t len, void *ud){
+    (void)ud;
+    char name[PREWARM_NAME_MAX];
+    if (len >= sizeof(name)) return 0;
+    memcpy(name, start, len);
+    name[len] = '\0';
+    if (!strchr(name, '/') && !executor_is_builtin(name) && prewarm_resolve(name)) {
+        Entry *e = lookup(name, 0);
+        if (e) { e->count++; dirty = 1; }
+    }
+    return 0;
+}
+
+void prewarm_learn(const char *line){
+    if (!line) return;
+    // The parser reports the first word of every atomic command (after '|',
+    // ';', '&' or the start of the line) in the same pass that validates it.
+    parse_command_names(line, learn_name, NULL);
+}
+
+static void save_counts(void){
+    if (!dirty || !counts_path[0]) return;
+    FILE *fp = fopen(counts_path, "w");
+    if (!fp) return;
+    for (int i = 0; i < PREWARM_SLOTS; i++)
+        if (table[i].name[0] && table[i].count) fprintf(fp, "%u %s\n", table[i].count, table[i].name);
+    fclose(fp);
+    dirty = 0;
+}
+
+static void warm_file(const char *path){
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+void prewarm_idle(void){
+    if (!isatty(STDIN_FILENO)) return; // scripted input never waits
+    save_counts();
+    check_path_env();
+    time_t now = time(NULL);
+    // Pick the PREWARM_TOP most used commands (simple selection, the table
+    // is small).
+    Entry *top[PREWARM_TOP];
+    int ntop = 0;
+    for (int i = 0; i < PREWARM_SLOTS; i++) {
+        Entry *e = &table[i];
+        if (!e->name[0] || e->count == 0) continue;
+        int pos = ntop;
+        while (pos > 0 && top[pos - 1]->count < e->count) pos--;
+        if (pos >= PREWARM_TOP) continue;
+        if (ntop < PREWARM_TOP) ntop++;
+        memmove(&top[pos + 1], &top[pos], (size_t)(ntop - 1 - pos) * sizeof(top[0]));
+        top[pos] = e;
+    }
+    for (int i = 0; i < ntop; i++) {
+        Entry *e = top[i];
+        if (now - e->warmed < PREWARM_INTERVAL) continue;
+        const char *path = prewarm_resolve(e->name);
+        if (path) warm_file(path);
+        e->warmed = now;
+    }
+}
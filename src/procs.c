@@ -0,0 +1,133 @@
+// procs.c: process helpers for signal delivery
+// --------------------------------------------
+// kill(pid, sig) is racy: between looking a pid up and signalling it, the
+// process can exit and the pid can be handed to an unrelated process.
+// A pidfd (Linux 5.3+) refers to one specific process for as long as we hold
+// it, so signals sent through pidfd_send_signal() can never hit a stranger.
+// The job table opens pidfds when jobs are created; ping uses them.
+//
+// The /proc scan (for name patterns and process groups) is cached for a
+// short time so several lookups in one command read /proc only once.
+#define _GNU_SOURCE // syscall()
+#include "procs.h"
+#include "signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/syscall.h>
+
+int procs_pidfd_open(pid_t pid){
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0); // pidfds are always close-on-exec
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int procs_send(pid_t pid, int pidfd, int sig){
+#ifdef SYS_pidfd_send_signal
+    if (pidfd >= 0) {
+        if (syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0) == 0) return 0;
+        if (errno != ENOSYS) return -1; // ESRCH: that process is gone
+    }
+#else
+    (void)pidfd;
+#endif
+    return kill(pid, sig);
+}
+
+int procs_wait(const int *pidfds, int n){
+    struct pollfd pfd[64];
+    int done = 0;
+    while (done < n) {
+        // poll() in batches; an exited process keeps its pidfd readable.
+        int k = 0;
+        for (int i = done; i < n && k < 64; i++) {
+            pfd[k].fd = pidfds[i]; pfd[k].events = POLLIN; pfd[k].revents = 0; k++;
+        }
+        int remaining = 0;
+        for (int i = 0; i < k; i++) if (pfd[i].fd >= 0) remaining++;
+        while (remaining > 0) {
+            int r = poll(pfd, (nfds_t)k, -1);
+            if (r < 0) {
+                if (errno != EINTR) return 0;
+                if (signals_take_interrupt()) return -1; // Ctrl-C: stop waiting
+                continue;
+            }
+            for (int i = 0; i < k; i++) {
+                if (pfd[i].fd >= 0 && pfd[i].revents) { pfd[i].fd = -1; remaining--; }
+            }
+        }
+        done += k;
+    }
+    return 0;
+}
+
+static ProcInfo *cache = NULL;
+static int cache_len = 0, cache_cap = 0;
+static struct timespec cache_time;
+static int cache_valid = 0;
+
+void procs_invalidate(void){ cache_valid = 0; }
+
+// Parse "pid (comm) state ppid pgrp ..." from /proc/<pid>/stat. The comm
+// may itself contain spaces and parentheses, so look for the last ')'.
+static int read_stat(const char *pid_dir, ProcInfo *pi){
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/proc/%s/stat", pid_dir);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    char *open_paren = strchr(buf, '(');
+    char *close_paren = strrchr(buf, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return 0;
+    size_t len = (size_t)(close_paren - open_paren - 1);
+    if (len >= sizeof(pi->comm)) len = sizeof(pi->comm) - 1;
+    memcpy(pi->comm, open_paren + 1, len);
+    pi->comm[len] = '\0';
+    char state; int ppid, pgrp;
+    if (sscanf(close_paren + 1, " %c %d %d", &state, &ppid, &pgrp) != 3) return 0;
+    pi->pid = (pid_t)atoi(pid_dir);
+    pi->pgid = (pid_t)pgrp;
+    return 1;
+}
+
+int procs_scan(const ProcInfo **out){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long age_ms = (now.tv_sec - cache_time.tv_sec) * 1000L + (now.tv_nsec - cache_time.tv_nsec) / 1000000L;
+    if (cache_valid && age_ms < PROCS_CACHE_MS) { *out = cache; return cache_len; }
+
+    cache_len = 0;
+    DIR *d = opendir("/proc");
+    if (d) {
+        struct dirent *ent;
+        while ((ent = readdir(d)) != NULL) {
+            if (ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+            if (cache_len == cache_cap) {
+                int ncap = cache_cap ? cache_cap * 2 : 256;
+                ProcInfo *n = realloc(cache, (size_t)ncap * sizeof(*n));
+                if (!n) break;
+                cache = n; cache_cap = ncap;
+            }
+            if (read_stat(ent->d_name, &cache[cache_len])) cache_len++;
+        }
+        closedir(d);
+    }
+    cache_time = now;
+    cache_valid = 1;
+    *out = cache;
+    return cache_len;
+}
@@ -8,6 +8,7 @@
 // and "/code/src" prints as "~/src".
 
 #include "prompt.h"
+#include "dirs.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -71,6 +72,9 @@ void prompt_init(void){
         shell_home=strdup("?");
         // continue. we'll still try to print prompts even if home unknown
     }
+    // Builtins resolve '~' and the cwd through descriptors (see dirs.c).
+    dirs_init();
+    dirs_set_home(shell_home);
 }
 
 void prompt_print(void){
@@ -95,4 +99,13 @@ void prompt_cleanup(void){
 
 const char* prompt_home(void){
     return shell_home;
-}
\ No newline at end of file
+}
+
+void prompt_set_home(const char *path){
+    if(!path) return;
+    char *copy = strdup(path);
+    if(!copy) return;
+    free(shell_home);
+    shell_home = copy;
+    dirs_set_home(shell_home);
+}
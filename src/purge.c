@@ -0,0 +1,288 @@
+// purge.c: rm -rf as a builtin
+// ----------------------------
+// Implements: purge-tree [-v] path...
+//   purge-tree build/ cache/   -> remove both trees
+//   purge-tree -v old          -> also print what was removed and how fast
+// Symlinks are removed, never followed. Errors are counted and the rest of
+// the tree is still removed; the first error is printed at the end. Like
+// rm, "/", "." and ".." operands are refused before anything is removed.
+// On a terminal a progress line is updated twice a second. Ctrl-C stops early.
+//
+// Walker: the thread pool + LIFO stack of usage.c and copy.c. A directory
+// task opens the directory relative to its parent's descriptor, unlinkat()s
+// every non-directory entry right away and queues a task per subdirectory.
+// Each directory holds a reference from each queued child; when the last one
+// is gone the directory is empty and is removed (unlinkat AT_REMOVEDIR
+// relative to its own parent), which in turn releases the parent. So
+// directories go bottom-up without a second pass or any full paths.
+#define _GNU_SOURCE // O_NOFOLLOW, syscall()
+#include "purge.h"
+#include "dirs.h"
+#include "outbuf.h"
+#include "signals.h"
+#include "statcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h> // DT_DIR
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define PURGE_MAX_THREADS 16
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+typedef struct DirRef {
+    int fd;
+    int refs;              // the directory itself + its queued children
+    struct DirRef *parent; // NULL: name is relative to the shell cwd
+    char *name;
+} DirRef;
+
+typedef struct Task {
+    DirRef *parent;
+    char *name;
+    struct Task *next;
+} Task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // work queued, or everything finished
+    pthread_cond_t done; // everything finished (for the watching thread)
+    Task *stack;
+    int active;
+    int cancel;
+    long files, dirs, errors;
+    char first_error[300];
+} Walk;
+
+static void fail(Walk *w, const char *name, int err){
+    pthread_mutex_lock(&w->lock);
+    if (!w->errors++)
+        snprintf(w->first_error, sizeof(w->first_error), "purge-tree: %s: %s", name, strerror(err));
+    pthread_mutex_unlock(&w->lock);
+}
+
+static int base_fd(const DirRef *parent){
+    return parent ? parent->fd : dirs_cwd_fd();
+}
+
+// Drop a reference; the last one removes the (now empty) directory and
+// releases its parent in turn.
+static void ref_release(Walk *w, DirRef *r){
+    while (r) {
+        pthread_mutex_lock(&w->lock);
+        int last = --r->refs == 0, cancel = w->cancel;
+        pthread_mutex_unlock(&w->lock);
+        if (!last) return;
+        close(r->fd);
+        if (!cancel) {
+            if (unlinkat(base_fd(r->parent), r->name, AT_REMOVEDIR) == 0) {
+                pthread_mutex_lock(&w->lock);
+                w->dirs++;
+                pthread_mutex_unlock(&w->lock);
+            } else {
+                fail(w, r->name, errno);
+            }
+        }
+        DirRef *parent = r->parent;
+        free(r->name);
+        free(r);
+        r = parent;
+    }
+}
+
+static void push_task(Walk *w, DirRef *parent, const char *name){
+    Task *t = malloc(sizeof(*t));
+    char *n = strdup(name);
+    if (!t || !n) { free(t); free(n); fail(w, name, ENOMEM); return; }
+    t->parent = parent;
+    t->name = n;
+    pthread_mutex_lock(&w->lock);
+    if (parent) parent->refs++;
+    t->next = w->stack;
+    w->stack = t;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void count_file(Walk *w, long n){
+    pthread_mutex_lock(&w->lock);
+    w->files += n;
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void process(Walk *w, Task *t){
+    int base = base_fd(t->parent);
+    int fd = openat(base, t->name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        // Not a directory (or a symlink to one): remove the name itself.
+        if ((errno == ENOTDIR || errno == ELOOP) && unlinkat(base, t->name, 0) == 0) count_file(w, 1);
+        else fail(w, t->name, errno);
+        return;
+    }
+    DirRef *me = malloc(sizeof(*me));
+    char *name = strdup(t->name);
+    if (!me || !name) { free(me); free(name); close(fd); fail(w, t->name, ENOMEM); return; }
+    *me = (DirRef){ .fd = fd, .refs = 1, .parent = t->parent, .name = name };
+    if (t->parent) { // the child keeps its parent alive until it is removed
+        pthread_mutex_lock(&w->lock);
+        t->parent->refs++;
+        pthread_mutex_unlock(&w->lock);
+    }
+    char buf[32768];
+    long removed = 0;
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buf, sizeof(buf));
+        if (n < 0) fail(w, t->name, errno);
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(buf + off);
+            off += d->d_reclen;
+            const char *e = d->d_name;
+            if (e[0] == '.' && (e[1] == '\0' || (e[1] == '.' && e[2] == '\0'))) continue;
+            if (d->d_type != DT_DIR) {
+                if (unlinkat(fd, e, 0) == 0) { removed++; continue; }
+                if (errno != EISDIR && !(d->d_type == DT_UNKNOWN && errno == EPERM)) {
+                    fail(w, e, errno);
+                    continue;
+                }
+            }
+            push_task(w, me, e);
+        }
+    }
+    count_file(w, removed);
+    ref_release(w, me);
+}
+
+static void *worker(void *arg){
+    Walk *w = arg;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (!w->stack && w->active > 0) pthread_cond_wait(&w->cond, &w->lock);
+        if (!w->stack) break;
+        Task *t = w->stack;
+        w->stack = t->next;
+        int skip = w->cancel;
+        w->active++;
+        pthread_mutex_unlock(&w->lock);
+        if (!skip) process(w, t);
+        ref_release(w, t->parent);
+        free(t->name);
+        free(t);
+        pthread_mutex_lock(&w->lock);
+        w->active--;
+        if (!w->stack && w->active == 0) {
+            pthread_cond_broadcast(&w->cond);
+            pthread_cond_signal(&w->done);
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+// 1 for operands rm -rf refuses too: a last component of "." or "..", and
+// anything that is the root directory (also via "//", "/..", symlinks).
+static int forbidden(const char *path){
+    size_t len = strlen(path);
+    while (len > 1 && path[len-1] == '/') len--;
+    size_t base = len;
+    while (base > 0 && path[base-1] != '/') base--;
+    size_t blen = len - base;
+    if ((blen == 1 && path[base] == '.') || (blen == 2 && path[base] == '.' && path[base+1] == '.')) return 1;
+    struct stat st, root;
+    return stat(path, &st) == 0 && stat("/", &root) == 0 &&
+           st.st_dev == root.st_dev && st.st_ino == root.st_ino;
+}
+
+static int purge_threads(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    // Mostly waiting on metadata I/O: use more threads than CPUs.
+    n = n > 0 ? n * 2 : 2;
+    if (n < 2) n = 2;
+    if (n > PURGE_MAX_THREADS) n = PURGE_MAX_THREADS;
+    return (int)n;
+}
+
+int run_purge_tree_argv(int argc, char **argv){
+    int verbose = 0, first = 1;
+    if (first < argc && strcmp(argv[first], "-v") == 0) { verbose = 1; first++; }
+    if (first >= argc) { out_puts(out_stdout(), "purge-tree: Invalid Syntax!"); return 1; }
+
+    Walk w;
+    memset(&w, 0, sizeof(w));
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+    pthread_cond_init(&w.done, NULL);
+    int refused = 0;
+    for (int i = first; i < argc; i++) {
+        if (forbidden(argv[i])) {
+            out_printf(out_stderr(), "purge-tree: refusing to remove '%s'\n", argv[i]);
+            refused = 1;
+            continue;
+        }
+        push_task(&w, NULL, argv[i]);
+    }
+    out_flush(out_stderr());
+    signals_take_interrupt(); // forget a Ctrl-C typed before this command
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pthread_t tids[PURGE_MAX_THREADS];
+    int nthreads = purge_threads(), started = 0;
+    for (int i = 0; i < nthreads; i++)
+        if (pthread_create(&tids[started], NULL, worker, &w) == 0) started++;
+    if (!started) worker(&w);
+
+    // This thread only watches: progress on a terminal, and Ctrl-C.
+    OutBuf *err = out_stderr();
+    int progress = out_is_tty(err), shown = 0;
+    pthread_mutex_lock(&w.lock);
+    while (w.stack || w.active > 0) {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += 500000000L;
+        if (until.tv_nsec >= 1000000000L) { until.tv_sec++; until.tv_nsec -= 1000000000L; }
+        pthread_cond_timedwait(&w.done, &w.lock, &until);
+        if (!w.cancel && signals_take_interrupt()) w.cancel = 1;
+        if (progress && (w.stack || w.active > 0)) {
+            out_printf(err, "\rpurge-tree: %ld files, %ld directories removed", w.files, w.dirs);
+            out_flush(err);
+            shown = 1;
+        }
+    }
+    pthread_mutex_unlock(&w.lock);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&w.cond);
+    pthread_cond_destroy(&w.done);
+    pthread_mutex_destroy(&w.lock);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    statcache_invalidate();
+
+    if (shown) out_fputs(err, "\r\033[K");
+    if (w.errors) {
+        out_printf(err, "%s", w.first_error);
+        if (w.errors > 1) out_printf(err, " (and %ld more errors)", w.errors - 1);
+        out_putc(err, '\n');
+    }
+    if (w.cancel) out_puts(err, "purge-tree: interrupted");
+    out_flush(err);
+    if (verbose) {
+        double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+        out_printf(out_stdout(), "%ld files, %ld directories removed in %.2fs\n", w.files, w.dirs, secs);
+        out_flush(out_stdout());
+    }
+    return w.errors || w.cancel || refused ? 1 : 0;
+}
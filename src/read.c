@@ -0,0 +1,106 @@
+// read.c: read a line into shell variables
+// ----------------------------------------
+// Implements: read [-r] [-d delim] [name...]
+//   read line            -> whole line (minus surrounding blanks) into $line
+//   read a b rest < f    -> first two fields into $a and $b, the rest in $rest
+//   read -d , item       -> read up to the next ',' instead of a newline
+// Without names the line goes to $REPLY. Fields are split on the characters
+// of $IFS (default: space, tab, newline). Without -r a backslash makes the
+// next character literal, and a backslash before the delimiter continues the
+// record on the next line.
+// Returns 0 when a full record was read, 1 at end of input (the variables
+// still receive whatever partial data there was).
+//
+// Input goes through lineread.c, so this never reads byte by byte and never
+// consumes more of a shared descriptor than the record it returns.
+#include "read.h"
+#include "lineread.h"
+#include "vars.h"
+#include "outbuf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int is_ifs(const char *ifs, char c){ return c != '\0' && strchr(ifs, c) != NULL; }
+static int is_ifs_space(const char *ifs, char c){ return (c == ' ' || c == '\t' || c == '\n') && is_ifs(ifs, c); }
+
+// Assign the characters chars[0..n) (lit[i] = escaped, never a separator)
+// to the variables, splitting on IFS.
+static void assign_fields(char **names, int nnames, const char *chars, const char *lit, size_t n){
+    const char *ifs = vars_get("IFS");
+    if (!ifs) ifs = " \t\n";
+    char *field = malloc(n + 1);
+    if (!field) return;
+    size_t i = 0;
+    for (int k = 0; k < nnames; k++) {
+        while (i < n && !lit[i] && is_ifs_space(ifs, chars[i])) i++;
+        size_t flen = 0;
+        if (k == nnames - 1) {
+            // Last name: the rest of the record minus trailing IFS blanks.
+            size_t end = n;
+            while (end > i && !lit[end - 1] && is_ifs_space(ifs, chars[end - 1])) end--;
+            memcpy(field, chars + i, end - i);
+            flen = end - i;
+            i = n;
+        } else {
+            while (i < n && (lit[i] || !is_ifs(ifs, chars[i]))) field[flen++] = chars[i++];
+            // Consume one separator: blanks, optionally around one non-blank IFS char.
+            while (i < n && !lit[i] && is_ifs_space(ifs, chars[i])) i++;
+            if (i < n && !lit[i] && is_ifs(ifs, chars[i]) && !is_ifs_space(ifs, chars[i])) i++;
+        }
+        field[flen] = '\0';
+        vars_set(names[k], field);
+    }
+    free(field);
+}
+
+int run_read_argv(int argc, char **argv){
+    int raw = 0, delim = '\n';
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        if (strcmp(argv[i], "-r") == 0) raw = 1;
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) delim = (unsigned char)argv[++i][0];
+        else { out_puts(out_stdout(), "read: Invalid Syntax!"); return 1; }
+    }
+    static char *reply_name[] = { "REPLY" };
+    char **names = i < argc ? &argv[i] : reply_name;
+    int nnames = i < argc ? argc - i : 1;
+    for (int k = 0; k < nnames; k++) {
+        if (!vars_valid_name(names[k])) { out_puts(out_stdout(), "read: Invalid Syntax!"); return 1; }
+    }
+    out_flush_all(); // a prompt printed just before must be visible
+
+    static char *rec = NULL; // reused between calls
+    static size_t cap = 0;
+    size_t len = 0;
+    char *chars = NULL, *lit = NULL;
+    size_t n = 0, ccap = 0;
+    int rc;
+    for (;;) {
+        rc = lr_read_record(STDIN_FILENO, delim, &rec, &cap, &len);
+        if (rc < 0) break;
+        if (len + n + 1 > ccap) {
+            ccap = (len + n + 1) * 2;
+            char *nc = realloc(chars, ccap), *nl = nc ? realloc(lit, ccap) : NULL;
+            if (nc) chars = nc;
+            if (!nc || !nl) { rc = -2; break; }
+            lit = nl;
+        }
+        int continued = 0;
+        for (size_t j = 0; j < len; j++) {
+            if (!raw && rec[j] == '\\') {
+                if (j + 1 == len) { continued = rc == 1; break; } // "\<delim>": join records
+                j++;
+                chars[n] = rec[j]; lit[n++] = 1;
+                continue;
+            }
+            chars[n] = rec[j]; lit[n++] = 0;
+        }
+        if (!continued) break;
+    }
+    if (rc == -2 && n == 0) { free(chars); free(lit); return 1; }
+    assign_fields(names, nnames, chars ? chars : "", lit ? lit : "", n);
+    free(chars);
+    free(lit);
+    return rc == 1 ? 0 : 1;
+}
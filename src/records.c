@@ -0,0 +1,571 @@
+// records.c: typed records between builtins
+// -----------------------------------------
+// Implements: where [-j] field op value | sortby [-j] [-r] field... |
+//             select [-j] field...
+//   reveal | where size -gt 1M | sortby -r size | select name size
+//   activities | where state = Stopped
+//   cat listing.ndjson | where type != dir
+// op is = (or ==, -eq), != (-ne), -lt, -le, -gt or -ge; '<' and '>' are
+// redirections in this shell. Integer fields compare as numbers, and an
+// integer operand may end in k, M or G (powers of 1024); everything else
+// compares as strings. sortby is stable and orders missing values first,
+// then numbers, then strings.
+//
+// reveal and activities produce records; where, sortby and select filter
+// them. The executor joins a run of such stages into one stage (the words
+// of each separated by "|" words), so the producer fills a table in memory
+// and every filter works on the typed values in place: nothing is
+// formatted or parsed in between, and a line like the first example runs
+// without a fork. Text is made only once, at the end: tab-separated
+// columns (cut's default delimiter), or NDJSON when a stage has -j or the
+// shell runs with --json. A filter that is not joined to a producer (after
+// an external command, or reading a file) parses NDJSON from stdin; any
+// other line becomes a record with a single "line" field.
+//
+// Storage: strings and value arrays come from a chunked arena freed in one
+// go; a record is a pointer to its values plus its input position (for the
+// stable sort), so filtering and sorting move 16-byte entries.
+#include "records.h"
+#include "activities.h"
+#include "json.h"
+#include "lineread.h"
+#include "outbuf.h"
+#include "reveal.h"
+#include "signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define REC_BLOCK (128 * 1024)
+#define REC_CHUNK (64 * 1024)
+
+enum { V_NONE, V_INT, V_STR };
+
+typedef struct {
+    int kind;
+    union { long long i; const char *s; } u;
+} Value;
+
+typedef struct {
+    Value *v;   // n values; columns added later read as V_NONE
+    int n;
+    size_t seq; // input position
+} Record;
+
+typedef struct Chunk {
+    struct Chunk *next;
+    size_t used, cap;
+    char data[];
+} Chunk;
+
+struct RecTable {
+    const char *cols[REC_MAX_COLS];
+    int ncols;
+    Record *recs;
+    size_t nrecs, cap;
+    Chunk *arena;
+    int oom;
+};
+
+static void *arena_alloc(RecTable *t, size_t n){
+    n = (n + 15) & ~(size_t)15;
+    Chunk *c = t->arena;
+    if (!c || c->cap - c->used < n) {
+        size_t cap = n > REC_CHUNK ? n : REC_CHUNK;
+        c = malloc(sizeof(Chunk) + cap);
+        if (!c) { t->oom = 1; return NULL; }
+        c->next = t->arena;
+        c->used = 0;
+        c->cap = cap;
+        t->arena = c;
+    }
+    void *p = c->data + c->used;
+    c->used += n;
+    return p;
+}
+
+static char *arena_strdup(RecTable *t, const char *s, size_t n){
+    char *d = arena_alloc(t, n + 1);
+    if (d) { memcpy(d, s, n); d[n] = '\0'; }
+    return d;
+}
+
+static void table_free(RecTable *t){
+    while (t->arena) {
+        Chunk *next = t->arena->next;
+        free(t->arena);
+        t->arena = next;
+    }
+    free(t->recs);
+}
+
+static int find_column(const RecTable *t, const char *name){
+    for (int c = 0; c < t->ncols; c++)
+        if (strcmp(t->cols[c], name) == 0) return c;
+    return -1;
+}
+
+int rec_column(RecTable *t, const char *name){
+    int c = find_column(t, name);
+    if (c >= 0 || t->ncols == REC_MAX_COLS) return c;
+    const char *copy = arena_strdup(t, name, strlen(name));
+    if (!copy) return -1;
+    t->cols[t->ncols] = copy;
+    return t->ncols++;
+}
+
+void rec_add(RecTable *t){
+    if (t->nrecs == t->cap) {
+        size_t ncap = t->cap ? t->cap * 2 : 256;
+        Record *nr = realloc(t->recs, ncap * sizeof(Record));
+        if (!nr) { t->oom = 1; return; }
+        t->recs = nr;
+        t->cap = ncap;
+    }
+    Value *v = arena_alloc(t, (size_t)t->ncols * sizeof(Value));
+    if (!v && t->ncols) return;
+    for (int c = 0; c < t->ncols; c++) v[c].kind = V_NONE;
+    t->recs[t->nrecs] = (Record){ .v = v, .n = t->ncols, .seq = t->nrecs };
+    t->nrecs++;
+}
+
+static const Value none = { .kind = V_NONE };
+
+static const Value *get(const Record *r, int col){
+    return col >= 0 && col < r->n ? &r->v[col] : &none;
+}
+
+// Slot for col in the newest record, widening it if the column is newer.
+static Value *slot(RecTable *t, int col){
+    if (!t->nrecs || col < 0) return NULL;
+    Record *r = &t->recs[t->nrecs - 1];
+    if (col >= r->n) {
+        Value *v = arena_alloc(t, (size_t)t->ncols * sizeof(Value));
+        if (!v) return NULL;
+        memcpy(v, r->v, (size_t)r->n * sizeof(Value));
+        for (int c = r->n; c < t->ncols; c++) v[c].kind = V_NONE;
+        r->v = v;
+        r->n = t->ncols;
+    }
+    return &r->v[col];
+}
+
+void rec_set_int(RecTable *t, int col, long long v){
+    Value *s = slot(t, col);
+    if (s) { s->kind = V_INT; s->u.i = v; }
+}
+
+static void set_str_n(RecTable *t, int col, const char *str, size_t n){
+    Value *s = slot(t, col);
+    const char *copy = s ? arena_strdup(t, str, n) : NULL;
+    if (copy) { s->kind = V_STR; s->u.s = copy; }
+}
+
+void rec_set_str(RecTable *t, int col, const char *s){ set_str_n(t, col, s, strlen(s)); }
+
+// ---- NDJSON input ----
+
+static const char *skip_ws(const char *p, const char *end){
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p;
+}
+
+static char *put_utf8(char *o, unsigned cp){
+    if (cp < 0x80) { *o++ = (char)cp; }
+    else if (cp < 0x800) { *o++ = (char)(0xC0 | cp >> 6); *o++ = (char)(0x80 | (cp & 0x3F)); }
+    else if (cp < 0x10000) {
+        *o++ = (char)(0xE0 | cp >> 12); *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *o++ = (char)(0xF0 | cp >> 18); *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F)); *o++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return o;
+}
+
+static int hex4(const char *p, const char *end, unsigned *out){
+    if (end - p < 4) return 0;
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned)(c - 'A' + 10);
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+// Decode the string starting after its opening quote into o (which has room
+// for as many bytes as the input). Returns the position after the closing
+// quote, or NULL if malformed; *olen gets the decoded length.
+static const char *json_string(const char *p, const char *end, char *o, size_t *olen){
+    char *start = o;
+    while (p < end && *p != '"') {
+        if (*p != '\\') { *o++ = *p++; continue; }
+        if (++p == end) return NULL;
+        char e = *p++;
+        switch (e) {
+        case '"': case '\\': case '/': *o++ = e; break;
+        case 'b': *o++ = '\b'; break;
+        case 'f': *o++ = '\f'; break;
+        case 'n': *o++ = '\n'; break;
+        case 'r': *o++ = '\r'; break;
+        case 't': *o++ = '\t'; break;
+        case 'u': {
+            unsigned cp, lo;
+            if (!hex4(p, end, &cp)) return NULL;
+            p += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                hex4(p + 2, end, &lo) && lo >= 0xDC00 && lo < 0xE000) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                p += 6;
+            }
+            o = put_utf8(o, cp);
+            break;
+        }
+        default: return NULL;
+        }
+    }
+    if (p == end) return NULL;
+    *olen = (size_t)(o - start);
+    return p + 1;
+}
+
+typedef struct {
+    int col;
+    int kind;
+    long long i;
+    const char *s;
+    size_t n;
+} Field;
+
+// One flat JSON object per line. Anything else (nested values included)
+// is kept as {"line": text}.
+static void parse_line(RecTable *t, const char *line, size_t len, char *scratch){
+    const char *p = skip_ws(line, line + len), *end = line + len;
+    Field f[REC_MAX_COLS];
+    int nf = 0, ok = 0;
+    char *o = scratch;
+    if (p < end && *p == '{') {
+        p = skip_ws(p + 1, end);
+        ok = p < end && *p == '}';
+        if (ok) p++;
+        while (!ok && p < end && *p == '"' && nf < REC_MAX_COLS) {
+            size_t klen;
+            char *key = o;
+            p = json_string(p + 1, end, o, &klen);
+            if (!p) break;
+            key[klen] = '\0';
+            o += klen + 1;
+            p = skip_ws(p, end);
+            if (p == end || *p != ':') break;
+            p = skip_ws(p + 1, end);
+            if (p == end) break;
+            Field *fd = &f[nf];
+            if (*p == '"') {
+                fd->kind = V_STR;
+                fd->s = o;
+                p = json_string(p + 1, end, o, &fd->n);
+                if (!p) break;
+                o += fd->n;
+            } else {
+                const char *v = p;
+                while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\r') p++;
+                if (p == v || *v == '{' || *v == '[') break;
+                char *num_end;
+                long long n = strtoll(v, &num_end, 10);
+                if (num_end == p && (*v == '-' || (*v >= '0' && *v <= '9'))) {
+                    fd->kind = V_INT;
+                    fd->i = n;
+                } else { // true, false, null, non-integer numbers: kept as strings
+                    fd->kind = V_STR;
+                    fd->s = v;
+                    fd->n = (size_t)(p - v);
+                }
+            }
+            fd->col = rec_column(t, key);
+            if (fd->col >= 0) nf++;
+            p = skip_ws(p, end);
+            if (p < end && *p == ',') { p = skip_ws(p + 1, end); continue; }
+            if (p < end && *p == '}') { p++; ok = 1; }
+            break;
+        }
+        if (ok && skip_ws(p, end) != end) ok = 0;
+    }
+    if (!ok) {
+        int col = rec_column(t, "line");
+        rec_add(t);
+        set_str_n(t, col, line, len);
+        return;
+    }
+    rec_add(t);
+    for (int i = 0; i < nf; i++) {
+        if (f[i].kind == V_INT) rec_set_int(t, f[i].col, f[i].i);
+        else set_str_n(t, f[i].col, f[i].s, f[i].n);
+    }
+}
+
+// Read all of stdin into t. Returns 0, or 1 on a read error or Ctrl-C.
+static int read_input(RecTable *t){
+    size_t cap = REC_BLOCK, have = 0;
+    char *buf = malloc(cap), *scratch = NULL;
+    size_t scratch_cap = 0;
+    int status = 0;
+    if (!buf) return 1;
+    for (;;) {
+        if (have == cap) { // a line longer than the buffer
+            char *nb = realloc(buf, cap * 2);
+            if (!nb) { status = 1; break; }
+            buf = nb;
+            cap *= 2;
+        }
+        ssize_t n = lr_read_block(STDIN_FILENO, buf + have, cap - have);
+        if (n == -2 || signals_take_interrupt()) { status = 1; break; }
+        int eof = n == 0;
+        const char *p = buf, *end = buf + have + (eof ? 0 : n), *nl;
+        if (eof && have) { buf[have] = '\n'; end = buf + have + 1; } // last line without '\n'
+        if (scratch_cap < cap + 1) {
+            free(scratch);
+            scratch_cap = cap + 1;
+            scratch = malloc(scratch_cap);
+            if (!scratch) { status = 1; break; }
+        }
+        while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+            if (nl > p) parse_line(t, p, (size_t)(nl - p), scratch);
+            p = nl + 1;
+        }
+        if (eof) break;
+        have = (size_t)(end - p);
+        memmove(buf, p, have);
+    }
+    free(buf);
+    free(scratch);
+    return status;
+}
+
+// ---- Filters ----
+
+// "1M" -> 1048576. 0 if s is not an integer.
+static int parse_number(const char *s, long long *out){
+    char *end;
+    if (!*s) return 0;
+    long long v = strtoll(s, &end, 10);
+    if (end == s) return 0;
+    if (*end == 'k' || *end == 'K') { v <<= 10; end++; }
+    else if (*end == 'M') { v <<= 20; end++; }
+    else if (*end == 'G') { v <<= 30; end++; }
+    *out = v;
+    return *end == '\0';
+}
+
+static int field_or_fail(const RecTable *t, const char *cmd, const char *name){
+    int c = find_column(t, name);
+    if (c < 0 && t->nrecs) out_printf(out_stderr(), "%s: no such field: %s\n", cmd, name);
+    return c;
+}
+
+enum { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+
+static const struct { const char *name; int op; } ops[] = {
+    { "=", OP_EQ }, { "==", OP_EQ }, { "-eq", OP_EQ }, { "!=", OP_NE }, { "-ne", OP_NE },
+    { "-lt", OP_LT }, { "-le", OP_LE }, { "-gt", OP_GT }, { "-ge", OP_GE },
+};
+
+static int where_records(RecTable *t, int argc, char **argv){
+    if (argc != 4) { out_puts(out_stdout(), "where: Invalid Syntax!"); return 1; }
+    int op = -1;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+        if (strcmp(argv[2], ops[i].name) == 0) op = ops[i].op;
+    if (op < 0) { out_puts(out_stdout(), "where: Invalid Syntax!"); return 1; }
+    int col = field_or_fail(t, "where", argv[1]);
+    if (col < 0) return t->nrecs ? 1 : 0;
+    const char *want = argv[3];
+    long long num;
+    int numeric = parse_number(want, &num);
+    size_t keep = 0;
+    for (size_t i = 0; i < t->nrecs; i++) {
+        const Value *v = get(&t->recs[i], col);
+        int cmp;
+        char tmp[24];
+        if (v->kind == V_NONE) continue;
+        if (v->kind == V_INT && numeric) {
+            cmp = (v->u.i > num) - (v->u.i < num);
+        } else if (v->kind == V_INT) {
+            snprintf(tmp, sizeof(tmp), "%lld", v->u.i);
+            cmp = strcmp(tmp, want);
+        } else {
+            cmp = strcmp(v->u.s, want);
+        }
+        int match = op == OP_EQ ? cmp == 0 : op == OP_NE ? cmp != 0 : op == OP_LT ? cmp < 0
+                  : op == OP_LE ? cmp <= 0 : op == OP_GT ? cmp > 0 : cmp >= 0;
+        if (match) t->recs[keep++] = t->recs[i];
+    }
+    t->nrecs = keep;
+    return 0;
+}
+
+// qsort() has no context argument; the shell is single-threaded here.
+static int sort_cols[REC_MAX_COLS], sort_ncols, sort_desc;
+
+static int cmp_value(const Value *a, const Value *b){
+    if (a->kind != b->kind) return a->kind - b->kind;
+    if (a->kind == V_INT) return (a->u.i > b->u.i) - (a->u.i < b->u.i);
+    if (a->kind == V_STR) return strcmp(a->u.s, b->u.s);
+    return 0;
+}
+
+static int cmp_records(const void *pa, const void *pb){
+    const Record *a = pa, *b = pb;
+    for (int k = 0; k < sort_ncols; k++) {
+        int c = cmp_value(get(a, sort_cols[k]), get(b, sort_cols[k]));
+        if (c) return sort_desc ? -c : c;
+    }
+    return (a->seq > b->seq) - (a->seq < b->seq); // stable
+}
+
+static int sortby_records(RecTable *t, int argc, char **argv){
+    int first = 1;
+    sort_desc = 0;
+    if (first < argc && strcmp(argv[first], "-r") == 0) { sort_desc = 1; first++; }
+    if (first >= argc || argc - first > REC_MAX_COLS) { out_puts(out_stdout(), "sortby: Invalid Syntax!"); return 1; }
+    sort_ncols = 0;
+    for (int i = first; i < argc; i++) {
+        int c = field_or_fail(t, "sortby", argv[i]);
+        if (c < 0 && t->nrecs) return 1;
+        sort_cols[sort_ncols++] = c;
+    }
+    for (size_t i = 0; i < t->nrecs; i++) t->recs[i].seq = i;
+    qsort(t->recs, t->nrecs, sizeof(Record), cmp_records);
+    return 0;
+}
+
+static int select_records(RecTable *t, int argc, char **argv){
+    int n = argc - 1;
+    if (n < 1 || n > REC_MAX_COLS) { out_puts(out_stdout(), "select: Invalid Syntax!"); return 1; }
+    int cols[REC_MAX_COLS];
+    const char *names[REC_MAX_COLS];
+    for (int k = 0; k < n; k++) {
+        cols[k] = field_or_fail(t, "select", argv[k + 1]);
+        if (cols[k] < 0 && t->nrecs) return 1;
+        names[k] = cols[k] >= 0 ? t->cols[cols[k]] : arena_strdup(t, argv[k + 1], strlen(argv[k + 1]));
+        if (!names[k]) return 1;
+    }
+    for (size_t i = 0; i < t->nrecs; i++) {
+        Record *r = &t->recs[i];
+        Value tmp[REC_MAX_COLS];
+        for (int k = 0; k < n; k++) tmp[k] = *get(r, cols[k]);
+        if (n > r->n) {
+            r->v = arena_alloc(t, (size_t)n * sizeof(Value));
+            if (!r->v) return 1;
+        }
+        memcpy(r->v, tmp, (size_t)n * sizeof(Value));
+        r->n = n;
+    }
+    memcpy(t->cols, names, (size_t)n * sizeof(names[0]));
+    t->ncols = n;
+    return 0;
+}
+
+// ---- Output ----
+
+static void render(const RecTable *t, int as_json){
+    OutBuf *o = out_stdout();
+    if (as_json) {
+        JsonWriter jw;
+        json_init(&jw, o);
+        for (size_t i = 0; i < t->nrecs; i++) {
+            const Record *r = &t->recs[i];
+            json_begin(&jw);
+            for (int c = 0; c < t->ncols; c++) {
+                const Value *v = get(r, c);
+                if (v->kind == V_INT) json_int(&jw, t->cols[c], v->u.i);
+                else if (v->kind == V_STR) json_str(&jw, t->cols[c], v->u.s);
+            }
+            json_end(&jw);
+        }
+        json_flush(&jw);
+        return;
+    }
+    for (size_t i = 0; i < t->nrecs; i++) {
+        const Record *r = &t->recs[i];
+        for (int c = 0; c < t->ncols; c++) {
+            const Value *v = get(r, c);
+            if (c) out_putc(o, '\t');
+            if (v->kind == V_INT) out_printf(o, "%lld", v->u.i);
+            else if (v->kind == V_STR) out_fputs(o, v->u.s);
+        }
+        out_putc(o, '\n');
+    }
+    out_flush(o);
+}
+
+// ---- Stages ----
+
+typedef int (*ProducerFn)(int argc, char **argv, RecTable *t, int *as_json);
+typedef int (*FilterFn)(RecTable *t, int argc, char **argv);
+
+static const struct { const char *name; ProducerFn fn; } producers[] = {
+    { "reveal", reveal_records },
+    { "activities", activities_records },
+};
+
+static const struct { const char *name; FilterFn fn; } filters[] = {
+    { "where", where_records },
+    { "sortby", sortby_records },
+    { "select", select_records },
+};
+
+static ProducerFn find_producer(const char *name){
+    for (size_t i = 0; name && i < sizeof(producers) / sizeof(producers[0]); i++)
+        if (strcmp(name, producers[i].name) == 0) return producers[i].fn;
+    return NULL;
+}
+
+static FilterFn find_filter(const char *name){
+    for (size_t i = 0; name && i < sizeof(filters) / sizeof(filters[0]); i++)
+        if (strcmp(name, filters[i].name) == 0) return filters[i].fn;
+    return NULL;
+}
+
+int records_is_filter(const char *name){ return find_filter(name) != NULL; }
+
+int records_joinable(const char *name){ return find_producer(name) || find_filter(name); }
+
+int run_records_argv(int argc, char **argv){
+    RecTable t;
+    memset(&t, 0, sizeof(t));
+    int as_json = json_default(), status = 0;
+    for (int start = 0; start < argc && !status; ) {
+        int end = start;
+        while (end < argc && strcmp(argv[end], "|") != 0) end++;
+        char *sep = argv[end];
+        argv[end] = NULL; // each stage sees a normal NULL-terminated argv
+        char **sv = argv + start;
+        int sc = end - start;
+        FilterFn filter = find_filter(sv[0]);
+        if (filter && sc > 1 && strcmp(sv[1], "-j") == 0) {
+            as_json = 1;
+            sv++; // "-j" takes the place of the name; filters only use argv[1..]
+            sc--;
+        }
+        if (!filter && start == 0 && find_producer(sv[0])) {
+            status = find_producer(sv[0])(sc, sv, &t, &as_json);
+        } else if (filter) {
+            if (start == 0) status = read_input(&t);
+            if (!status) status = filter(&t, sc, sv);
+        } else {
+            out_printf(out_stdout(), "%s: Invalid Syntax!\n", sv[0]);
+            status = 1;
+        }
+        argv[end] = sep;
+        start = end + 1;
+    }
+    if (t.oom) { out_puts(out_stderr(), "records: out of memory"); status = 1; }
+    if (!status) render(&t, as_json);
+    table_free(&t);
+    return status;
+}
@@ -6,7 +6,12 @@
 // Options:
 //   -a : include hidden entries (names starting with '.')
 //   -l : print one per line (otherwise print space-separated on one line)
-// Path rules mirror hop/cd: ~ . .. - and normal paths.
+//   -j : print one JSON object per entry (name, type, size, mtime); also the
+//        default when the shell was started with --json
+// Piped into a record filter (where, sortby, select) the same fields are
+// passed on as typed records instead (records.c).
+// Path rules mirror hop/cd: ~ . .. - and normal paths. Targets are opened
+// relative to the directory descriptors kept by dirs.c (openat + fdopendir).
 //
 // Design choices for beginners:
 // - We collect entries then qsort() them for stable output.
@@ -14,14 +19,19 @@
 // - We intentionally do not show metadata like permissions to keep it short.
 
 #include "reveal.h"
-#include "prompt.h"
 #include "hop.h"
+#include "json.h"
+#include "dirs.h"
+#include "outbuf.h"
+#include "statcache.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <linux/limits.h> // for PATH_MAX
 #include <errno.h>
 
 typedef struct {
@@ -76,10 +86,74 @@ static int cmp_ascii(const void *a, const void *b) {
 extern int hop_prev_cwd_available(void);
 extern const char* hop_get_prev_cwd(void);
 
-static int list_dir(const char *path, int show_all, int line_by_line) {
-    DIR *d = opendir(path);
+static const char *type_name(mode_t m) {
+    if (S_ISDIR(m)) return "dir";
+    if (S_ISREG(m)) return "file";
+    if (S_ISLNK(m)) return "symlink";
+    if (S_ISFIFO(m)) return "fifo";
+    if (S_ISSOCK(m)) return "socket";
+    if (S_ISCHR(m) || S_ISBLK(m)) return "device";
+    return "other";
+}
+
+// Metadata for entry name of directory d (path relative to base). Lookups
+// go through the stat cache as path/name relative to base (a dirs.h
+// descriptor, which the cache can key on); names too long for that use the
+// open directory directly.
+static int stat_entry(DIR *d, int base, const char *path, const char *name, struct stat *st) {
+    char full[PATH_MAX];
+    if (strcmp(path, ".") == 0)
+        return statcache_stat(base, name, st, AT_SYMLINK_NOFOLLOW) == 0;
+    if ((size_t)snprintf(full, sizeof(full), "%s/%s", path, name) < sizeof(full))
+        return statcache_stat(base, full, st, AT_SYMLINK_NOFOLLOW) == 0;
+    return fstatat(dirfd(d), name, st, AT_SYMLINK_NOFOLLOW) == 0;
+}
+
+// Emit sorted names as NDJSON. Metadata is looked up right before each
+// record is written, so only the name list is held in memory.
+static void print_json(DIR *d, int base, const char *path, const Vec *v) {
+    JsonWriter jw;
+    json_init(&jw, out_stdout());
+    for (size_t i = 0; i < v->len; i++) {
+        struct stat st;
+        int have = stat_entry(d, base, path, v->items[i], &st);
+        json_begin(&jw);
+        json_str(&jw, "name", v->items[i]);
+        json_str(&jw, "type", have ? type_name(st.st_mode) : "unknown");
+        if (have) {
+            json_int(&jw, "size", (long long)st.st_size);
+            json_int(&jw, "mtime", (long long)st.st_mtime);
+        }
+        json_end(&jw);
+    }
+    json_flush(&jw);
+}
+
+// The same fields as print_json, as typed records (records.c).
+static void fill_records(DIR *d, int base, const char *path, const Vec *v, RecTable *t) {
+    int name = rec_column(t, "name"), type = rec_column(t, "type");
+    int size = rec_column(t, "size"), mtime = rec_column(t, "mtime");
+    for (size_t i = 0; i < v->len; i++) {
+        struct stat st;
+        int have = stat_entry(d, base, path, v->items[i], &st);
+        rec_add(t);
+        rec_set_str(t, name, v->items[i]);
+        rec_set_str(t, type, have ? type_name(st.st_mode) : "unknown");
+        if (have) {
+            rec_set_int(t, size, (long long)st.st_size);
+            rec_set_int(t, mtime, (long long)st.st_mtime);
+        }
+    }
+}
+
+// List path resolved relative to the directory descriptor base, or hand
+// the entries to records when it is not NULL.
+static int list_dir(int base, const char *path, int show_all, int line_by_line, int as_json, RecTable *records) {
+    int fd = dirs_open_dir(base, path);
+    DIR *d = fd >= 0 ? fdopendir(fd) : NULL;
     if (!d) {
-        puts("No such directory!");
+        if (fd >= 0) close(fd);
+        out_puts(out_stdout(), "No such directory!");
         return 0;
     }
     Vec v; vec_init(&v);
@@ -89,18 +163,22 @@ static int list_dir(const char *path, int show_all, int line_by_line) {
         if (!show_all && name[0] == '.') continue; // skip hidden unless -a
         if (!vec_push(&v, name)) { vec_free(&v); closedir(d); return 0; }
     }
-    closedir(d);
     qsort(v.items, v.len, sizeof(char*), cmp_ascii);
-    if (line_by_line) {
-        for (size_t i = 0; i < v.len; i++) puts(v.items[i]);
+    if (records) {
+        fill_records(d, base, path, &v, records);
+    } else if (as_json) {
+        print_json(d, base, path, &v);
+    } else if (line_by_line) {
+        for (size_t i = 0; i < v.len; i++) out_puts(out_stdout(), v.items[i]);
     } else {
         // Simple ls-like: space-separated on one line
         for (size_t i = 0; i < v.len; i++) {
-            fputs(v.items[i], stdout);
-            if (i + 1 < v.len) fputc(' ', stdout);
+            out_fputs(out_stdout(), v.items[i]);
+            if (i + 1 < v.len) out_putc(out_stdout(), ' ');
         }
-        if (v.len > 0) fputc('\n', stdout);
+        if (v.len > 0) out_putc(out_stdout(), '\n');
     }
+    closedir(d);
     vec_free(&v);
     return 1;
 }
@@ -126,7 +204,7 @@ bool try_handle_reveal(const char *input) {
                 else if (tok[i] == 'l') line_by_line = 1;
                 else {
                     // Unknown flag -> treat like invalid syntax for reveal
-                    puts("reveal: Invalid Syntax!");
+                    out_puts(out_stdout(), "reveal: Invalid Syntax!");
                     free(tok);
                     for (size_t j=0;j<positional.len;j++) free(positional.items[j]);
                     free(positional.items);
@@ -142,7 +220,7 @@ bool try_handle_reveal(const char *input) {
     }
 
     if (positional.len > 1) {
-        puts("reveal: Invalid Syntax!");
+        out_puts(out_stdout(), "reveal: Invalid Syntax!");
         for (size_t j=0;j<positional.len;j++) free(positional.items[j]);
         free(positional.items);
         return true;
@@ -150,6 +228,7 @@ bool try_handle_reveal(const char *input) {
 
     // Determine target directory similar to hop
     const char *target = NULL;
+    int base = dirs_cwd_fd();
     char *resolved = NULL;
     if (positional.len == 0) {
         // No target: list current working directory
@@ -157,26 +236,28 @@ bool try_handle_reveal(const char *input) {
     } else {
         const char *arg = positional.items[0];
         if (strcmp(arg, "~") == 0) {
-            target = prompt_home();
+            base = dirs_home_fd();
+            target = ".";
         } else if (strcmp(arg, ".") == 0) {
             target = ".";
         } else if (strcmp(arg, "..") == 0) {
             target = "..";
         } else if (strcmp(arg, "-") == 0) {
             if (!hop_prev_cwd_available()) {
-                puts("No such directory!");
+                out_puts(out_stdout(), "No such directory!");
                 for (size_t j=0;j<positional.len;j++) free(positional.items[j]);
                 free(positional.items);
                 return true;
             }
-            target = hop_get_prev_cwd();
+            base = dirs_prev_fd();
+            target = ".";
         } else {
             target = arg;
         }
     }
 
     if (!target || target[0] == '\0') {
-        puts("No such directory!");
+        out_puts(out_stdout(), "No such directory!");
         for (size_t j=0;j<positional.len;j++) free(positional.items[j]);
         free(positional.items);
         free(resolved);
@@ -184,7 +265,7 @@ bool try_handle_reveal(const char *input) {
     }
 
     // Attempt to open directory and list
-    (void)list_dir(target, show_all, line_by_line);
+    (void)list_dir(base, target, show_all, line_by_line, json_default(), NULL);
 
     for (size_t j=0;j<positional.len;j++) free(positional.items[j]);
     free(positional.items);
@@ -193,9 +274,10 @@ bool try_handle_reveal(const char *input) {
 }
 
 // Simplified argv-based version: flags can be combined (-al) and at most one positional path.
-int run_reveal_argv(int argc, char **argv) {
+static int reveal_argv(int argc, char **argv, RecTable *records, int *as_json) {
     if (argc <= 0) return 1;
     int show_all = 0, line_by_line = 0; const char *target = ".";
+    int base = dirs_cwd_fd();
     int positional_count = 0;
     for (int i = 1; i < argc; i++) {
         const char *a = argv[i];
@@ -203,21 +285,31 @@ int run_reveal_argv(int argc, char **argv) {
             for (int j = 1; a[j]; j++) {
                 if (a[j] == 'a') show_all = 1;
                 else if (a[j] == 'l') line_by_line = 1;
-                else { puts("reveal: Invalid Syntax!"); return 1; }
+                else if (a[j] == 'j') *as_json = 1;
+                else { out_puts(out_stdout(), "reveal: Invalid Syntax!"); return 1; }
             }
             continue;
         }
         positional_count++;
-        if (positional_count > 1) { puts("reveal: Invalid Syntax!"); return 1; }
-        if (strcmp(a, "~") == 0) target = prompt_home();
+        if (positional_count > 1) { out_puts(out_stdout(), "reveal: Invalid Syntax!"); return 1; }
+        base = dirs_cwd_fd();
+        if (strcmp(a, "~") == 0) { base = dirs_home_fd(); target = "."; }
         else if (strcmp(a, ".") == 0) target = ".";
         else if (strcmp(a, "..") == 0) target = "..";
         else if (strcmp(a, "-") == 0) {
-            if (!hop_prev_cwd_available()) { puts("No such directory!"); return 1; }
-            target = hop_get_prev_cwd();
+            if (!hop_prev_cwd_available()) { out_puts(out_stdout(), "No such directory!"); return 1; }
+            base = dirs_prev_fd(); target = ".";
         } else target = a;
     }
-    if (!target) { puts("No such directory!"); return 1; }
-    list_dir(target, show_all, line_by_line);
-    return 0;
+    int ok = list_dir(base, target, show_all, line_by_line, *as_json, records);
+    return (ok || !records) ? 0 : 1; // a plain listing has always returned 0
+}
+
+int run_reveal_argv(int argc, char **argv) {
+    int as_json = json_default();
+    return reveal_argv(argc, argv, NULL, &as_json);
+}
+
+int reveal_records(int argc, char **argv, RecTable *t, int *as_json) {
+    return reveal_argv(argc, argv, t, as_json);
 }
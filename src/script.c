@@ -0,0 +1,123 @@
+// script.c: command files, and nested shell.out runs without exec
+// ---------------------------------------------------------------
+// `shell.out [--json] file` reads its command lines from file instead of the
+// terminal: no prompt, no history, and the terminal is not taken over. Blank
+// lines and lines starting with '#' (so also a #! line) are skipped. The
+// exit status is the status of the last line.
+//
+// Scripts often run other scripts through the shell itself. Exec'ing
+// shell.out again costs execve(), dynamic loading and a full start-up
+// (prompt, signals, history, prewarm counts) per call. Instead the executor
+// asks script_is_self() whether a pipeline stage would start this very
+// binary (same device and inode as /proc/self/exe, as of startup) on a file.
+// If so the forked child calls script_run_inline(): it resets what a fresh
+// process would not have (shell variables, options, jobs, `last` capture,
+// previous directory, input buffered for the parent), makes '~' the current
+// directory like prompt_init() would, and interprets the file directly.
+// Cached PATH lookups (prewarm.c) and the directory descriptors are simply
+// inherited.
+#include "script.h"
+#include "capture.h"
+#include "dirs.h"
+#include "executor.h"
+#include "hop.h"
+#include "jobs.h"
+#include "json.h"
+#include "lineread.h"
+#include "outbuf.h"
+#include "parser.h"
+#include "prompt.h"
+#include "setopt.h"
+#include "statcache.h"
+#include "vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+static int self_known = 0;
+static dev_t self_dev;
+static ino_t self_ino;
+
+int script_arg_index(char **argv){
+    for (int i = 1; argv[i]; i++) {
+        if (strcmp(argv[i], "--serve") == 0) return -1;
+        if (strcmp(argv[i], "--workers") == 0) { if (argv[i + 1]) i++; continue; }
+        if (strcmp(argv[i], "--json") == 0) continue;
+        return i;
+    }
+    return -1;
+}
+
+void script_init_self(void){
+    struct stat st;
+    if (stat("/proc/self/exe", &st) != 0) return;
+    self_dev = st.st_dev;
+    self_ino = st.st_ino;
+    self_known = 1;
+}
+
+int script_is_self(const char *path, char **argv){
+    if (!self_known || !path || script_arg_index(argv) < 0) return 0;
+    struct stat st;
+    return statcache_stat(dirs_cwd_fd(), path, &st, 0) == 0 && st.st_dev == self_dev && st.st_ino == self_ino;
+}
+
+int script_run_file(const char *path){
+    int fd = openat(dirs_cwd_fd(), path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        out_printf(out_stderr(), "%s: %s\n", path, strerror(errno));
+        out_flush(out_stderr());
+        return 127;
+    }
+    // Like main(): the executor hands the terminal to foreground pipelines
+    // and takes it back, which must not stop us.
+    struct sigaction ign;
+    memset(&ign, 0, sizeof(ign));
+    ign.sa_handler = SIG_IGN;
+    sigaction(SIGTTOU, &ign, NULL);
+    sigaction(SIGTTIN, &ign, NULL);
+
+    char *line = NULL;
+    size_t cap = 0, len = 0;
+    int status = 0;
+    while (lr_read_record(fd, '\n', &line, &cap, &len) >= 0) {
+        executor_poll_background();
+        const char *p = line + strspn(line, " \t\r");
+        if (*p == '\0' || *p == '#') continue;
+        if (!parse_command(line)) {
+            out_puts(out_stdout(), "Invalid Syntax!");
+            status = 1;
+            continue;
+        }
+        status = execute_first_cmd_group(line);
+    }
+    free(line);
+    close(fd);
+    out_flush_all();
+    return status;
+}
+
+void script_run_inline(char **argv){
+    int i = script_arg_index(argv);
+    int json = 0;
+    for (int k = 1; k < i; k++) if (strcmp(argv[k], "--json") == 0) json = 1;
+    json_set_default(json);
+    vars_clear();
+    setopt_reset();
+    jobs_forget_all();
+    capture_reset();
+    lr_forget_buffered();
+    char *cwd = getcwd(NULL, 0);
+    if (cwd) prompt_set_home(cwd);
+    free(cwd);
+    hop_set_prev_cwd(NULL);
+    statcache_invalidate();
+    int status = script_run_file(argv[i]);
+    out_flush_all();
+    _exit(status & 0xff);
+}
@@ -0,0 +1,166 @@
+// seq.c: print a sequence of integers
+// -----------------------------------
+// Implements: seq [-w] [-s sep] [first [incr]] last
+//   seq 5            -> 1 2 3 4 5 (one per line)
+//   seq -w 8 2 12    -> 08 10 12
+//   seq -s , 3       -> 1,2,3
+// As a builtin, seq never forks/execs and streams into pipes in 64 KiB
+// chunks, so "seq 1 100000000 | head" costs almost nothing.
+//
+// Formatting is the hot loop, so it avoids printf:
+// - step +1 from a non-negative start (the common case) keeps the number as
+//   ASCII digits and increments it in place, carrying like an odometer;
+//   most numbers cost one digit change plus a short copy
+// - any other step formats two digits per division using a lookup table
+#include "seq.h"
+#include "outbuf.h"
+#include "signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define SEQ_CHUNK 65536
+#define SEQ_NUM_MAX 24 // digits of a long long plus sign
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static int parse_ll(const char *s, long long *out){
+    char *end = NULL;
+    errno = 0;
+    long long v = strtoll(s, &end, 10);
+    if (errno != 0 || end == s || *end != '\0') return 0;
+    *out = v;
+    return 1;
+}
+
+// Format v right-aligned so that it ends at out[SEQ_NUM_MAX + width];
+// returns a pointer to the first character. Zero-pads to width (sign
+// included, like coreutils -w).
+static char *format_ll(char *buf, long long v, int width){
+    char *end = buf + SEQ_NUM_MAX + width;
+    char *p = end;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    while (u >= 100) {
+        unsigned idx = (unsigned)(u % 100) * 2;
+        u /= 100;
+        *--p = digit_pairs[idx + 1];
+        *--p = digit_pairs[idx];
+    }
+    if (u >= 10) {
+        *--p = digit_pairs[u * 2 + 1];
+        *--p = digit_pairs[u * 2];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    int sign = v < 0;
+    while (end - p < width - sign) *--p = '0';
+    if (sign) *--p = '-';
+    return p;
+}
+
+static int digits_of(long long v){
+    char buf[SEQ_NUM_MAX + 1];
+    char *p = format_ll(buf, v, 0);
+    return (int)(buf + SEQ_NUM_MAX - p);
+}
+
+typedef struct {
+    char data[SEQ_CHUNK];
+    size_t used;
+    int interrupted;
+} Chunk;
+
+static void chunk_flush(Chunk *c){
+    out_write(out_stdout(), c->data, c->used);
+    c->used = 0;
+    if (signals_take_interrupt()) c->interrupted = 1;
+}
+
+static void chunk_add(Chunk *c, const char *s, size_t n, const char *sep, size_t seplen){
+    if (c->used + n + seplen > sizeof(c->data)) chunk_flush(c);
+    memcpy(c->data + c->used, s, n);
+    c->used += n;
+    memcpy(c->data + c->used, sep, seplen);
+    c->used += seplen;
+}
+
+int run_seq_argv(int argc, char **argv){
+    const char *sep = "\n";
+    int equal_width = 0;
+    int i = 1;
+    while (i < argc) {
+        if (strcmp(argv[i], "-w") == 0) { equal_width = 1; i++; }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) { sep = argv[i + 1]; i += 2; }
+        else break;
+    }
+    long long nums[3];
+    int n = argc - i;
+    if (n < 1 || n > 3) { out_puts(out_stdout(), "seq: Invalid Syntax!"); return 1; }
+    for (int k = 0; k < n; k++) {
+        if (!parse_ll(argv[i + k], &nums[k])) { out_puts(out_stdout(), "seq: Invalid Syntax!"); return 1; }
+    }
+    long long first = n >= 2 ? nums[0] : 1;
+    long long incr = n == 3 ? nums[1] : 1;
+    long long last = nums[n - 1];
+    if (incr == 0) { out_puts(out_stdout(), "seq: Invalid Syntax!"); return 1; }
+    if ((incr > 0 && first > last) || (incr < 0 && first < last)) return 0;
+
+    // Number of values, computed in unsigned arithmetic so it can't overflow.
+    unsigned long long span = incr > 0 ? (unsigned long long)last - (unsigned long long)first
+                                       : (unsigned long long)first - (unsigned long long)last;
+    unsigned long long step = incr > 0 ? (unsigned long long)incr : 0ULL - (unsigned long long)incr;
+    unsigned long long count = span / step + 1;
+
+    int width = 0;
+    if (equal_width) {
+        int a = digits_of(first), b = digits_of(last);
+        width = a > b ? a : b;
+    }
+    size_t seplen = strlen(sep);
+    signals_take_interrupt(); // forget a Ctrl-C typed before this command
+
+    Chunk *c = malloc(sizeof(*c));
+    if (!c) return 1;
+    c->used = 0;
+    c->interrupted = 0;
+    char buf[2 * SEQ_NUM_MAX + 1];
+
+    if (incr == 1 && first >= 0 && seplen <= SEQ_NUM_MAX) {
+        // Odometer: digits live in num[start..SEQ_NUM_MAX), followed by the
+        // separator, so each value is a single copy into the chunk.
+        char num[2 * SEQ_NUM_MAX];
+        char *p = format_ll(buf, first, width);
+        int len = (int)(buf + SEQ_NUM_MAX + width - p);
+        int start = SEQ_NUM_MAX - len;
+        memcpy(num + start, p, (size_t)len);
+        memcpy(num + SEQ_NUM_MAX, sep, seplen);
+        size_t total = SEQ_NUM_MAX - (size_t)start + seplen;
+        for (unsigned long long k = 0; k < count && !c->interrupted; k++) {
+            if (c->used + total > sizeof(c->data)) chunk_flush(c);
+            memcpy(c->data + c->used, num + start, total);
+            c->used += total;
+            int d = SEQ_NUM_MAX - 1;
+            while (d >= start && num[d] == '9') num[d--] = '0';
+            if (d >= start) num[d]++;
+            else if (start > 0) { num[--start] = '1'; total++; }
+        }
+    } else {
+        long long v = first;
+        for (unsigned long long k = 0; k < count && !c->interrupted; k++, v = (long long)((unsigned long long)v + (unsigned long long)incr)) {
+            char *p = format_ll(buf, v, width);
+            chunk_add(c, p, (size_t)(buf + SEQ_NUM_MAX + width - p), sep, seplen);
+        }
+    }
+    // The last separator becomes a newline, like coreutils seq.
+    if (c->used >= seplen) c->used -= seplen;
+    if (c->used == sizeof(c->data)) chunk_flush(c);
+    c->data[c->used++] = '\n';
+    chunk_flush(c);
+    free(c);
+    out_flush(out_stdout());
+    return 0;
+}
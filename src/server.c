@@ -0,0 +1,262 @@
+// server.c: command-server daemon mode
+// ------------------------------------
+// `shell.out --serve /path.sock [--workers N]` keeps fully initialized shell
+// sessions warm and runs command lines sent over a Unix domain socket, so
+// automation that issues many small commands doesn't pay shell startup
+// every time. See server.h for the framing.
+//
+// Design (the classic pre-fork model):
+// - The parent initializes everything once (prompt/home, history), binds the
+//   socket, then forks N workers. Each worker inherits that warm state and
+//   blocks in accept() on the shared listening socket; the kernel hands each
+//   new connection to exactly one idle worker, so N bounds concurrency.
+// - A worker serves one connection at a time: for every request it installs
+//   the passed descriptors as fds 0/1/2, hops into the requested cwd, runs the
+//   line through the normal parser/executor and restores its own fds.
+// - The parent only supervises: it respawns workers that die and, on
+//   SIGINT/SIGTERM, stops them and removes the socket file.
+
+#include "server.h"
+#include "parser.h"
+#include "executor.h"
+#include "prompt.h"
+#include "outbuf.h"
+#include "dirs.h"
+#include "jobs.h"
+#include "capture.h"
+#include "vars.h"
+#include "setopt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define MAX_WORKERS 64
+#define MAX_PASSED_FDS 3
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void handle_stop(int sig){ (void)sig; g_stop = 1; }
+
+// read()/write() until len bytes moved; return 0 on EOF or error.
+static int read_full(int fd, void *buf, size_t len){
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n; len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int write_full(int fd, const void *buf, size_t len){
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n; len -= (size_t)n;
+    }
+    return 1;
+}
+
+// Receive the request header plus any SCM_RIGHTS descriptors attached to it.
+// Returns 1 on success, 0 on EOF/error. fds[] is filled with -1 for missing.
+static int recv_header(int conn, ServerReqHdr *hdr, int fds[MAX_PASSED_FDS]){
+    for (int i=0;i<MAX_PASSED_FDS;i++) fds[i] = -1;
+    union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)]; } ctl;
+    struct iovec iov = { .iov_base = hdr, .iov_len = sizeof(*hdr) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov; msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf; msg.msg_controllen = sizeof(ctl.buf);
+    ssize_t n;
+    do { n = recvmsg(conn, &msg, 0); } while (n < 0 && errno == EINTR);
+    if (n <= 0) return 0;
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        int nfd = (int)((c->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        int *data = (int*)CMSG_DATA(c);
+        for (int i=0;i<nfd;i++) {
+            if (i < MAX_PASSED_FDS) fds[i] = data[i];
+            else close(data[i]); // more than we asked for: don't leak
+        }
+    }
+    // The descriptors arrive with the first byte; the rest may trickle in.
+    if ((size_t)n < sizeof(*hdr) && !read_full(conn, (char*)hdr + n, sizeof(*hdr) - (size_t)n)) {
+        for (int i=0;i<MAX_PASSED_FDS;i++) if (fds[i] != -1) { close(fds[i]); fds[i] = -1; }
+        return 0;
+    }
+    return 1;
+}
+
+static uint64_t elapsed_ns(const struct timespec *a, const struct timespec *b){
+    return (uint64_t)(b->tv_sec - a->tv_sec) * 1000000000ULL + (uint64_t)(b->tv_nsec - a->tv_nsec);
+}
+
+// Run one request with fds[] as stdin/stdout/stderr. Returns the status.
+static int run_request(const char *line, const char *cwd, int fds[MAX_PASSED_FDS]){
+    int saved[MAX_PASSED_FDS];
+    out_flush_all();
+    for (int i=0;i<MAX_PASSED_FDS;i++) {
+        saved[i] = fcntl(i, F_DUPFD_CLOEXEC, MAX_PASSED_FDS);
+        int src = fds[i];
+        if (src == -1) src = open("/dev/null", i == 0 ? O_RDONLY : O_WRONLY);
+        if (src != -1) { dup2(src, i); if (src != fds[i]) close(src); }
+    }
+    const char *home = prompt_home();
+    int status;
+    if (cwd[0] ? chdir(cwd) != 0 : (home && chdir(home) != 0)) {
+        // Never run in whatever directory an earlier request left behind.
+        out_puts(out_stdout(), "No such directory!");
+        status = 1;
+    } else {
+        dirs_sync_cwd();
+        executor_poll_background();
+        if (!parse_command(line)) { out_puts(out_stdout(), "Invalid Syntax!"); status = -1; }
+        else status = execute_first_cmd_group(line);
+    }
+    out_flush_all();
+    for (int i=0;i<MAX_PASSED_FDS;i++) {
+        if (saved[i] != -1) { dup2(saved[i], i); close(saved[i]); }
+    }
+    return status;
+}
+
+// Serve requests on one connection until the client hangs up.
+static void serve_connection(int conn){
+    char *line = malloc(SERVER_MAX_LINE + 1);
+    char *cwd = malloc(SERVER_MAX_LINE + 1);
+    if (!line || !cwd) { free(line); free(cwd); return; }
+    for (;;) {
+        ServerReqHdr hdr;
+        int fds[MAX_PASSED_FDS];
+        if (!recv_header(conn, &hdr, fds)) break;
+        ServerRespHdr resp = { .magic = SERVER_MAGIC, .status = -1, .elapsed_ns = 0 };
+        int ok = hdr.magic == SERVER_MAGIC && hdr.line_len <= SERVER_MAX_LINE && hdr.cwd_len <= SERVER_MAX_LINE;
+        if (ok) ok = read_full(conn, line, hdr.line_len) && read_full(conn, cwd, hdr.cwd_len);
+        if (ok) {
+            line[hdr.line_len] = '\0';
+            cwd[hdr.cwd_len] = '\0';
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            resp.status = run_request(line, cwd, fds);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            resp.elapsed_ns = elapsed_ns(&t0, &t1);
+        }
+        for (int i=0;i<MAX_PASSED_FDS;i++) if (fds[i] != -1) close(fds[i]);
+        if (!write_full(conn, &resp, sizeof(resp)) || !ok) break; // malformed: drop the client
+    }
+    free(line);
+    free(cwd);
+    // Jobs still running belong to the client that left: never report them
+    // to the next one. Their zombies are collected between connections.
+    // Neither may its kept output, variables or options reach the next client.
+    jobs_forget_all();
+    setopt_reset();
+    capture_reset();
+    vars_clear();
+}
+
+static void worker_loop(int listen_fd){
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGPIPE, SIG_IGN); // a vanished client must not kill the session
+    // The executor hands the client's terminal to foreground jobs with
+    // tcsetpgrp(); like the interactive shell, never get stopped for it.
+    signal(SIGTTOU, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    for (;;) {
+        while (waitpid(-1, NULL, WNOHANG) > 0) { } // jobs of earlier clients
+        int conn = accept(listen_fd, NULL, NULL);
+        if (conn < 0) { if (errno == EINTR) continue; _exit(1); }
+        fcntl(conn, F_SETFD, FD_CLOEXEC); // commands we run must not hold the client open
+        serve_connection(conn);
+        close(conn);
+    }
+}
+
+static pid_t spawn_worker(int listen_fd){
+    out_flush_all();
+    pid_t pid = fork();
+    if (pid == 0) { worker_loop(listen_fd); _exit(0); }
+    if (pid < 0) perror("fork");
+    return pid;
+}
+
+int server_run(const char *sock_path, int workers){
+    if (!sock_path || !*sock_path) { fputs("serve: missing socket path\n", stderr); return 2; }
+    if (workers < 1) workers = 1;
+    if (workers > MAX_WORKERS) workers = MAX_WORKERS;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) { fputs("serve: socket path too long\n", stderr); return 2; }
+    strcpy(addr.sun_path, sock_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) { perror("socket"); return 1; }
+    fcntl(listen_fd, F_SETFD, FD_CLOEXEC);
+    struct stat st;
+    if (lstat(sock_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "serve: %s exists and is not a socket\n", sock_path);
+            close(listen_fd);
+            return 2;
+        }
+        // Only a socket nobody listens on is stale; never steal a live one.
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int rc = probe < 0 ? -1 : connect(probe, (struct sockaddr*)&addr, sizeof(addr));
+        int err = errno;
+        if (probe >= 0) close(probe);
+        if (rc == 0) {
+            fprintf(stderr, "serve: %s is already being served\n", sock_path);
+            close(listen_fd);
+            return 2;
+        }
+        if (err != ECONNREFUSED) {
+            fprintf(stderr, "serve: %s: %s\n", sock_path, strerror(err));
+            close(listen_fd);
+            return 2;
+        }
+        unlink(sock_path);
+    }
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); close(listen_fd); return 1; }
+    if (listen(listen_fd, 64) < 0) { perror("listen"); close(listen_fd); unlink(sock_path); return 1; }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);  // no SA_RESTART: waitpid() must return
+    sigaction(SIGTERM, &sa, NULL);
+
+    pid_t pool[MAX_WORKERS];
+    for (int i=0;i<workers;i++) pool[i] = spawn_worker(listen_fd);
+
+    while (!g_stop) {
+        int st;
+        pid_t dead = waitpid(-1, &st, 0);
+        if (dead < 0) { if (errno == EINTR) continue; break; }
+        for (int i=0;i<workers;i++) {
+            if (pool[i] == dead && !g_stop) { pool[i] = spawn_worker(listen_fd); break; }
+        }
+    }
+
+    for (int i=0;i<workers;i++) if (pool[i] > 0) kill(pool[i], SIGTERM);
+    while (waitpid(-1, NULL, 0) > 0 || errno == EINTR) { }
+    close(listen_fd);
+    unlink(sock_path);
+    return 0;
+}
@@ -0,0 +1,60 @@
+// setopt.c: shell options
+// -----------------------
+// Implements: setopt [name [value]]
+//   setopt               -> list options ("autobg off")
+//   setopt autobg 30s    -> background foreground pipelines after 30 seconds
+//   setopt autobg off    -> never (also: 0)
+// Durations are whole seconds with an optional s, m or h suffix.
+//
+// autobg: the executor arms an alarm when it starts waiting for a foreground
+// pipeline. If it fires first, the pipeline goes to the job table exactly as
+// after Ctrl-Z, except that it keeps running, and the prompt comes back; the
+// job is then reported like any other background job. Builtins that run
+// inside the shell itself are never backgrounded.
+#include "setopt.h"
+#include "outbuf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+static unsigned autobg_secs = 0;
+
+unsigned setopt_autobg_seconds(void){ return autobg_secs; }
+
+void setopt_reset(void){ autobg_secs = 0; }
+
+// "off" -> 0, "90" / "90s" / "2m" / "1h" -> seconds. -1 if malformed.
+static long parse_duration(const char *s){
+    if (strcmp(s, "off") == 0) return 0;
+    if (*s < '0' || *s > '9') return -1;
+    char *end;
+    unsigned long v = strtoul(s, &end, 10);
+    unsigned long unit = 1;
+    if (*end == 's') end++;
+    else if (*end == 'm') { unit = 60; end++; }
+    else if (*end == 'h') { unit = 3600; end++; }
+    if (*end || v > UINT_MAX / unit) return -1;
+    return (long)(v * unit);
+}
+
+static void print_duration(OutBuf *o, const char *name, unsigned secs){
+    if (!secs) out_printf(o, "%s off\n", name);
+    else if (secs % 3600 == 0) out_printf(o, "%s %uh\n", name, secs / 3600);
+    else if (secs % 60 == 0) out_printf(o, "%s %um\n", name, secs / 60);
+    else out_printf(o, "%s %us\n", name, secs);
+}
+
+int run_setopt_argv(int argc, char **argv){
+    OutBuf *o = out_stdout();
+    if (argc == 1 || (argc == 2 && strcmp(argv[1], "autobg") == 0)) {
+        print_duration(o, "autobg", autobg_secs);
+        out_flush(o);
+        return 0;
+    }
+    if (argc == 3 && strcmp(argv[1], "autobg") == 0) {
+        long secs = parse_duration(argv[2]);
+        if (secs >= 0) { autobg_secs = (unsigned)secs; return 0; }
+    }
+    out_puts(o, "setopt: Invalid Syntax!");
+    return 1;
+}
@@ -19,9 +19,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/time.h>
+
+static volatile sig_atomic_t interrupted = 0;
+static volatile sig_atomic_t alarmed = 0;
 
 static void handle_sigint(int sig) {
     (void)sig;
+    interrupted = 1;
     // Write a newline so the prompt doesn't get messed up
     write(STDOUT_FILENO, "\n", 1);
 }
@@ -52,6 +57,47 @@ void signals_process_pending(void) {
     // or rely on EINTR to wake up the main loop.
 }
 
+int signals_take_interrupt(void) {
+    int was = interrupted;
+    interrupted = 0;
+    return was;
+}
+
+static void handle_sigalrm(int sig) {
+    (void)sig;
+    alarmed = 1;
+}
+
+void signals_alarm(unsigned secs) {
+    // Installed on first use: script mode never calls signals_init(), and the
+    // default action would kill the shell.
+    static int installed = 0;
+    if (secs && !installed) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = handle_sigalrm;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = 0; // no SA_RESTART: interrupt the waitpid() in progress
+        sigaction(SIGALRM, &sa, NULL);
+        installed = 1;
+    }
+    alarmed = 0;
+    // After the first expiry the timer keeps firing every 100 ms until it is
+    // cancelled. An alarm that lands between the caller's signals_take_alarm()
+    // check and its blocking call is then repeated and still interrupts it.
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    it.it_value.tv_sec = secs;
+    if (secs) it.it_interval.tv_usec = 100000;
+    setitimer(ITIMER_REAL, &it, NULL);
+}
+
+int signals_take_alarm(void) {
+    int was = alarmed;
+    alarmed = 0;
+    return was;
+}
+
 void signals_reset_for_child(void) {
     struct sigaction sa_dfl;
     memset(&sa_dfl, 0, sizeof(sa_dfl));
@@ -64,4 +110,5 @@ void signals_reset_for_child(void) {
     // Reset SIGTTOU/SIGTTIN as well since they are ignored in main.c
     sigaction(SIGTTOU, &sa_dfl, NULL);
     sigaction(SIGTTIN, &sa_dfl, NULL);
+    sigaction(SIGALRM, &sa_dfl, NULL);
 }
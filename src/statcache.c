@@ -0,0 +1,87 @@
+// statcache.c: remember stat() results for the length of a command line
+// ---------------------------------------------------------------------
+// One command line can ask about the same path several times: PATH lookups
+// for each pipeline stage, memo's dependency checks, 'reveal -j' metadata.
+// Each answer is kept here, keyed by (dirfd, flags, name), until something
+// may have changed it:
+// - the start of every command line (statcache_invalidate() from executor),
+// - the end of anything that ran in a child process (it may have written
+//   anywhere), including background jobs being started,
+// - in-shell operations that change the filesystem (copy, purge-tree, memo,
+//   output redirections) or the directories behind dirs.h descriptors.
+// Invalidating only bumps a generation counter, so it costs nothing; slots
+// and the name arena are reused from the next generation on.
+//
+// Work done by background jobs while the line runs is not seen; the cache is
+// meant to be short-lived, not coherent.
+#define _GNU_SOURCE // AT_SYMLINK_NOFOLLOW
+#include "statcache.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#define SC_SLOTS 512          // hash table size (power of two)
+#define SC_ARENA (32 * 1024)  // bytes for cached names per generation
+
+typedef struct {
+    unsigned gen;   // entry is valid when gen == generation
+    unsigned hash;
+    int dirfd;      // -1 for absolute names (dirfd is ignored then)
+    int flags;
+    unsigned name;  // offset into arena
+    int err;        // 0 or the errno of a failed stat
+    struct stat st;
+} Entry;
+
+static Entry table[SC_SLOTS];
+static char arena[SC_ARENA];
+static size_t arena_used = 0;
+static unsigned generation = 1;
+static int used = 0;
+
+void statcache_invalidate(void){
+    generation++;
+    arena_used = 0;
+    used = 0;
+}
+
+static unsigned hash_key(int dirfd, int flags, const char *name){
+    unsigned h = 2166136261u ^ (unsigned)dirfd ^ ((unsigned)flags << 16); // FNV-1a
+    while (*name) { h ^= (unsigned char)*name++; h *= 16777619u; }
+    return h;
+}
+
+int statcache_stat(int dirfd, const char *name, struct stat *st, int flags){
+    flags &= AT_SYMLINK_NOFOLLOW;
+    int key_fd = name[0] == '/' ? -1 : dirfd;
+    unsigned h = hash_key(key_fd, flags, name);
+    unsigned i = h & (SC_SLOTS - 1);
+    Entry *e = NULL;
+    for (int probes = 0; probes < SC_SLOTS; probes++, i = (i + 1) & (SC_SLOTS - 1)) {
+        Entry *c = &table[i];
+        if (c->gen != generation) { e = c; break; } // free slot: not cached
+        if (c->hash == h && c->dirfd == key_fd && c->flags == flags && strcmp(arena + c->name, name) == 0) {
+            if (c->err) { errno = c->err; return -1; }
+            *st = c->st;
+            return 0;
+        }
+    }
+    int rc = fstatat(dirfd, name, st, flags);
+    int err = rc == 0 ? 0 : errno;
+    size_t len = strlen(name) + 1;
+    // Keep the table at most 3/4 full so misses stay short.
+    if (e && used < SC_SLOTS * 3 / 4 && arena_used + len <= SC_ARENA) {
+        memcpy(arena + arena_used, name, len);
+        e->gen = generation;
+        e->hash = h;
+        e->dirfd = key_fd;
+        e->flags = flags;
+        e->name = (unsigned)arena_used;
+        e->err = err;
+        if (rc == 0) e->st = *st;
+        arena_used += len;
+        used++;
+    }
+    if (rc != 0) errno = err;
+    return rc;
+}
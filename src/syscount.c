@@ -0,0 +1,323 @@
+// syscount.c: count the system calls of a command
+// -----------------------------------------------
+// Implements: syscount cmd [args...]
+//   syscount make -j8     -> runs make, then prints a table like `strace -c`:
+//     % time     seconds  usecs/call     calls    errors syscall
+//     ------ ----------- ----------- --------- --------- ----------------
+//      61.20    0.004210          12       342        17 openat
+// The table goes to stderr so the command's own output stays clean. Time is
+// wall time between syscall entry and exit, so blocking calls show up too.
+//
+// How it works: the child waits on a pipe until the shell has attached with
+// PTRACE_SEIZE, then execs. PTRACE_O_TRACESYSGOOD marks syscall stops
+// (SIGTRAP|0x80) apart from real SIGTRAPs, and the fork/vfork/clone options
+// attach every process and thread the command creates. PTRACE_GET_SYSCALL_INFO
+// decodes entry and exit stops without any architecture-specific registers.
+//
+// Job control works as for any foreground command: the command gets its own
+// process group and the terminal, Ctrl-C reaches it normally, and on Ctrl-Z
+// the tracer detaches (printing the counts so far) and the command becomes a
+// stopped job that fg/bg can resume, untraced. Only processes that stay in
+// the command's process group are followed: the tracer waits on the group,
+// so a process that leaves it (setpgid, setsid) is detached and runs on
+// untraced.
+#define _GNU_SOURCE
+#include "syscount.h"
+#include "jobs.h"
+#include "outbuf.h"
+#include "prewarm.h"
+#include "signals.h"
+#include "statcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#define SC_MAX 512 // syscall numbers tracked (covers the 64-bit Linux ABIs)
+
+#define SC(n) [__NR_##n] = #n
+static const char *const sc_names[SC_MAX] = {
+    SC(read), SC(write), SC(close), SC(fstat), SC(lseek), SC(mmap), SC(mprotect),
+    SC(munmap), SC(brk), SC(rt_sigaction), SC(rt_sigprocmask), SC(rt_sigreturn),
+    SC(ioctl), SC(pread64), SC(pwrite64), SC(readv), SC(writev), SC(sched_yield),
+    SC(mremap), SC(msync), SC(madvise), SC(dup), SC(nanosleep), SC(getpid),
+    SC(sendfile), SC(socket), SC(connect), SC(accept), SC(sendto), SC(recvfrom),
+    SC(sendmsg), SC(recvmsg), SC(shutdown), SC(bind), SC(listen), SC(getsockname),
+    SC(getpeername), SC(setsockopt), SC(getsockopt), SC(clone), SC(execve),
+    SC(exit), SC(wait4), SC(kill), SC(uname), SC(fcntl), SC(flock), SC(fsync),
+    SC(fdatasync), SC(truncate), SC(ftruncate), SC(getcwd), SC(chdir), SC(fchdir),
+    SC(fchmod), SC(fchown), SC(umask), SC(gettimeofday), SC(getrlimit),
+    SC(getrusage), SC(sysinfo), SC(getuid), SC(getgid), SC(setuid), SC(setgid),
+    SC(geteuid), SC(getegid), SC(setpgid), SC(getppid), SC(setsid),
+    SC(getgroups), SC(sigaltstack), SC(statfs), SC(fstatfs), SC(prctl),
+    SC(gettid), SC(futex), SC(sched_getaffinity), SC(getdents64),
+    SC(set_tid_address), SC(fadvise64), SC(clock_gettime), SC(clock_nanosleep),
+    SC(exit_group), SC(epoll_ctl), SC(tgkill), SC(waitid), SC(openat), SC(mkdirat),
+    SC(fchownat), SC(newfstatat), SC(unlinkat), SC(renameat), SC(linkat),
+    SC(symlinkat), SC(readlinkat), SC(fchmodat), SC(faccessat), SC(pselect6),
+    SC(ppoll), SC(set_robust_list), SC(splice), SC(tee), SC(sync_file_range),
+    SC(vmsplice), SC(utimensat), SC(epoll_pwait), SC(eventfd2), SC(epoll_create1),
+    SC(dup3), SC(pipe2), SC(prlimit64), SC(getrandom), SC(memfd_create),
+    SC(copy_file_range), SC(preadv2), SC(pwritev2), SC(statx), SC(rseq),
+    SC(pidfd_send_signal), SC(pidfd_open), SC(clone3), SC(close_range),
+    SC(openat2), SC(faccessat2),
+#ifdef __NR_fork // older ABIs (x86-64) keep the pre-*at calls
+    SC(open), SC(stat), SC(lstat), SC(poll), SC(access), SC(pipe), SC(select),
+    SC(dup2), SC(fork), SC(vfork), SC(getdents), SC(creat), SC(link),
+    SC(unlink), SC(symlink), SC(readlink), SC(chmod), SC(chown), SC(rename),
+    SC(mkdir), SC(rmdir), SC(getpgrp), SC(arch_prctl), SC(epoll_wait),
+#endif
+};
+#undef SC
+
+typedef struct {
+    unsigned long calls, errors;
+    unsigned long long ns;
+} ScStat;
+
+typedef struct {
+    pid_t tid;
+    int nr;               // syscall in progress, -1 between calls
+    struct timespec t0;   // when it was entered
+} Tracee;
+
+typedef struct {
+    ScStat stats[SC_MAX];
+    Tracee *t;
+    int n, cap;
+} Trace;
+
+static Tracee *tracee(Trace *tr, pid_t tid, int add){
+    for (int i = 0; i < tr->n; i++) if (tr->t[i].tid == tid) return &tr->t[i];
+    if (!add) return NULL;
+    if (tr->n == tr->cap) {
+        int ncap = tr->cap ? tr->cap * 2 : 16;
+        Tracee *nt = realloc(tr->t, (size_t)ncap * sizeof(*nt));
+        if (!nt) return NULL;
+        tr->t = nt;
+        tr->cap = ncap;
+    }
+    Tracee *t = &tr->t[tr->n++];
+    t->tid = tid;
+    t->nr = -1;
+    return t;
+}
+
+static void drop_tracee(Trace *tr, pid_t tid){
+    Tracee *t = tracee(tr, tid, 0);
+    if (t) *t = tr->t[--tr->n];
+}
+
+static void on_syscall_stop(Trace *tr, Tracee *t){
+    struct __ptrace_syscall_info info;
+    if (ptrace(PTRACE_GET_SYSCALL_INFO, t->tid, (void *)sizeof(info), &info) <= 0) return;
+    if (info.op == PTRACE_SYSCALL_INFO_ENTRY) {
+        t->nr = info.entry.nr < SC_MAX ? (int)info.entry.nr : -1;
+        if (t->nr >= 0) tr->stats[t->nr].calls++; // exit_group never returns
+        clock_gettime(CLOCK_MONOTONIC, &t->t0);
+    } else if (info.op == PTRACE_SYSCALL_INFO_EXIT && t->nr >= 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ScStat *s = &tr->stats[t->nr];
+        s->errors += info.exit.is_error != 0;
+        s->ns += (unsigned long long)((now.tv_sec - t->t0.tv_sec) * 1000000000LL + (now.tv_nsec - t->t0.tv_nsec));
+        t->nr = -1;
+    }
+}
+
+static int by_time(const void *a, const void *b, void *ud){
+    const ScStat *st = ud;
+    unsigned long long x = st[*(const int *)a].ns, y = st[*(const int *)b].ns;
+    return (x < y) - (x > y);
+}
+
+static void print_table(const Trace *tr){
+    int order[SC_MAX], n = 0;
+    unsigned long long total_ns = 0;
+    unsigned long calls = 0, errors = 0;
+    for (int i = 0; i < SC_MAX; i++) {
+        if (!tr->stats[i].calls) continue;
+        order[n++] = i;
+        total_ns += tr->stats[i].ns;
+        calls += tr->stats[i].calls;
+        errors += tr->stats[i].errors;
+    }
+    qsort_r(order, (size_t)n, sizeof(int), by_time, (void *)tr->stats);
+    OutBuf *o = out_stderr();
+    const char *rule = "------ ----------- ----------- --------- --------- ----------------\n";
+    out_fputs(o, "% time     seconds  usecs/call     calls    errors syscall\n");
+    out_fputs(o, rule);
+    for (int k = 0; k < n; k++) {
+        const ScStat *s = &tr->stats[order[k]];
+        char unknown[24];
+        const char *name = sc_names[order[k]];
+        if (!name) { snprintf(unknown, sizeof(unknown), "syscall_%d", order[k]); name = unknown; }
+        out_printf(o, "%6.2f %11.6f %11llu %9lu ", total_ns ? 100.0 * (double)s->ns / (double)total_ns : 0.0,
+                   (double)s->ns / 1e9, s->ns / 1000 / s->calls, s->calls);
+        if (s->errors) out_printf(o, "%9lu %s\n", s->errors, name);
+        else out_printf(o, "%9s %s\n", "", name);
+    }
+    out_fputs(o, rule);
+    out_printf(o, "100.00 %11.6f %11llu %9lu %9lu total\n", (double)total_ns / 1e9,
+               calls ? total_ns / 1000 / calls : 0, calls, errors);
+    out_flush(o);
+}
+
+// Let go of tracee tid once it is no longer in the command's group pgid:
+// waitpid(-pgid) would never report its stops again, and a tracee nobody
+// resumes hangs forever. It gets stopped (or found exited), detached with
+// any signal it was about to receive, and dropped.
+static void release(Trace *tr, pid_t tid){
+    int st;
+    ptrace(PTRACE_INTERRUPT, tid, NULL, NULL);
+    while (waitpid(tid, &st, __WALL) < 0) if (errno != EINTR) { drop_tracee(tr, tid); return; }
+    int sig = 0;
+    if (WIFSTOPPED(st) && !(st >> 16) && WSTOPSIG(st) != (SIGTRAP | 0x80)) sig = WSTOPSIG(st);
+    if (WIFSTOPPED(st)) ptrace(PTRACE_DETACH, tid, NULL, (void *)(long)sig);
+    drop_tracee(tr, tid);
+}
+
+// Release every tracee that has left group pgid (setpgid/setsid); this
+// also catches the other threads of a process that left.
+static void release_leavers(Trace *tr, pid_t pgid){
+    for (int i = 0; i < tr->n; ) {
+        pid_t tid = tr->t[i].tid;
+        if (getpgid(tid) != pgid) release(tr, tid); // drop moves the last entry to i
+        else i++;
+    }
+}
+
+static int is_stop_signal(int sig){
+    return sig == SIGSTOP || sig == SIGTSTP || sig == SIGTTIN || sig == SIGTTOU;
+}
+
+int run_syscount_argv(int argc, char **argv){
+    if (argc < 2) { out_puts(out_stdout(), "syscount: Invalid Syntax!"); return 1; }
+    char **cmd = &argv[1];
+    const char *exe = prewarm_resolve(cmd[0]);
+    int go[2];
+    if (pipe(go) != 0) { perror("syscount: pipe"); return 1; }
+    out_flush_all();
+    pid_t pid = fork();
+    if (pid < 0) { perror("syscount: fork"); close(go[0]); close(go[1]); return 1; }
+    if (pid == 0) {
+        setpgid(0, 0);
+        signals_reset_for_child();
+        close(go[1]);
+        char c;
+        while (read(go[0], &c, 1) < 0 && errno == EINTR) { } // wait for the tracer
+        close(go[0]);
+        if (exe) execv(exe, cmd);
+        execvp(cmd[0], cmd);
+        fputs("Command not found!\n", stderr);
+        _exit(127);
+    }
+    close(go[0]);
+    setpgid(pid, pid);
+    long opts = PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK |
+                PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL;
+    int traced = ptrace(PTRACE_SEIZE, pid, NULL, (void *)opts) == 0;
+    if (!traced) perror("syscount: ptrace");
+    jobs_set_foreground(pid, &pid, 1, cmd[0]);
+    jobs_give_terminal(pid);
+    close(go[1]); // let the child exec
+    if (!traced) {
+        int st;
+        while (waitpid(pid, &st, WUNTRACED) < 0 && errno == EINTR) { }
+        jobs_take_terminal();
+        int status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+        if (WIFSTOPPED(st)) { // Ctrl-Z: a stopped job, as for any command
+            int jobnum = jobs_move_foreground_to_background_stopped();
+            if (jobnum != -1) {
+                out_printf(out_stdout(), "[%d] Stopped %s\n", jobnum, cmd[0]);
+                out_flush(out_stdout());
+            }
+            status = 148;
+        }
+        jobs_clear_foreground();
+        return status;
+    }
+
+    Trace *tr = calloc(1, sizeof(*tr));
+    if (!tr || !tracee(tr, pid, 1)) { kill(-pid, SIGKILL); free(tr); tr = NULL; }
+    // A seized tracee keeps running; stop it once so PTRACE_SYSCALL can start.
+    ptrace(PTRACE_INTERRUPT, pid, NULL, NULL);
+    int status = 1, stopped = 0;
+    while (tr && tr->n > 0) {
+        int st;
+        pid_t tid = waitpid(-pid, &st, __WALL);
+        if (tid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (WIFEXITED(st) || WIFSIGNALED(st)) {
+            if (tid == pid) status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+            drop_tracee(tr, tid);
+            continue;
+        }
+        if (!WIFSTOPPED(st)) continue;
+        Tracee *t = tracee(tr, tid, 0);
+        if (!t) { // a new child or thread, attached automatically
+            tracee(tr, tid, 1);
+            ptrace(PTRACE_SYSCALL, tid, NULL, NULL);
+            continue;
+        }
+        int sig = WSTOPSIG(st), event = (unsigned)st >> 16;
+        if (sig == (SIGTRAP | 0x80)) {
+            on_syscall_stop(tr, t);
+            int nr = t->nr;
+            if (nr == __NR_setsid || nr == __NR_setpgid) {
+                // Entering a group change. If it succeeds the exit stop is
+                // already outside the group: wait for it on this thread.
+                ptrace(PTRACE_SYSCALL, tid, NULL, NULL);
+                while (waitpid(tid, &st, __WALL) < 0 && errno == EINTR) { }
+                if (WIFSTOPPED(st) && WSTOPSIG(st) == (SIGTRAP | 0x80)) on_syscall_stop(tr, t);
+                else if (!WIFSTOPPED(st)) { drop_tracee(tr, tid); continue; }
+                if (getpgid(tid) == pid) {
+                    ptrace(PTRACE_SYSCALL, tid, NULL, NULL);
+                    if (nr == __NR_setpgid) release_leavers(tr, pid); // moved a child
+                    continue;
+                }
+                int deliver = WSTOPSIG(st) != (SIGTRAP | 0x80) && !(st >> 16) ? WSTOPSIG(st) : 0;
+                ptrace(PTRACE_DETACH, tid, NULL, (void *)(long)deliver);
+                drop_tracee(tr, tid);
+                release_leavers(tr, pid);
+                continue;
+            }
+            ptrace(PTRACE_SYSCALL, tid, NULL, NULL);
+        } else if (event == PTRACE_EVENT_STOP && is_stop_signal(sig)) {
+            stopped = 1; // group-stop (Ctrl-Z): hand the job over to job control
+            break;
+        } else if (event) {
+            ptrace(PTRACE_SYSCALL, tid, NULL, NULL); // fork/clone events
+        } else {
+            ptrace(PTRACE_SYSCALL, tid, NULL, (void *)(long)sig); // deliver the signal
+        }
+    }
+    if (tr && !stopped) release_leavers(tr, pid);
+    if (stopped) {
+        for (int i = 0; i < tr->n; i++) ptrace(PTRACE_DETACH, tr->t[i].tid, NULL, NULL);
+        kill(-pid, SIGSTOP); // detaching may have swallowed pending stop signals
+    }
+    jobs_take_terminal();
+    if (tr) print_table(tr);
+    if (stopped) {
+        int jobnum = jobs_move_foreground_to_background_stopped();
+        if (jobnum != -1) {
+            out_printf(out_stdout(), "[%d] Stopped %s\n", jobnum, cmd[0]);
+            out_flush(out_stdout());
+        }
+        status = 148;
+    }
+    jobs_clear_foreground();
+    statcache_invalidate(); // the traced command may have changed files
+    if (tr) free(tr->t);
+    free(tr);
+    return status;
+}
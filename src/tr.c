@@ -0,0 +1,277 @@
+// tr.c: translate, delete and squeeze bytes
+// -----------------------------------------
+// Implements: tr [-c] [-d] [-s] set1 [set2]
+//   tr a-z A-Z          -> upper-case stdin
+//   tr -d '\r'          -> drop carriage returns
+//   tr -s ' '           -> collapse runs of spaces
+//   tr -cd '[:alnum:]'  -> keep only letters and digits
+// Sets understand ranges (a-z), escapes (\n \t \\ \NNN) and the POSIX
+// classes ([:alpha:], [:digit:], [:space:], ...). A short set2 is padded
+// with its last byte. -c uses the complement of set1; -s with set2 squeezes
+// the bytes of set2 after translating or deleting.
+//
+// Bytes only (no multibyte locales): the whole job is a 256-entry map plus
+// two byte sets, applied to 128 KiB blocks in place. Most input is left
+// unchanged by a typical tr, so the hot loop is "find the next byte that
+// needs work": with SSSE3 that test runs on 16 bytes at a time using two
+// pshufb lookups into a 256-bit membership bitmap split by nibble.
+#include "tr.h"
+#include "lineread.h"
+#include "outbuf.h"
+#include "signals.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <unistd.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+#define TR_BLOCK (128 * 1024)
+#define TR_SET_MAX 4096 // bytes in an expanded set
+#define TR_RUN 64        // bytes mapped after each hit
+
+// ---- byte sets ----
+
+// member[] answers one byte; lo[0]/lo[1] hold the same set for the SIMD
+// test: bit h of lo[h >> 3][l] is set when byte (h << 4 | l) is a member.
+typedef struct {
+    unsigned char member[256];
+    uint8_t lo[2][16];
+    int empty;
+} ByteSet;
+
+static void byteset_init(ByteSet *s){
+    memset(s, 0, sizeof(*s));
+    s->empty = 1;
+}
+
+static void byteset_add(ByteSet *s, unsigned char c){
+    s->member[c] = 1;
+    s->lo[c >> 7][c & 15] |= (uint8_t)(1u << ((c >> 4) & 7));
+    s->empty = 0;
+}
+
+static size_t span_scalar(const ByteSet *s, const unsigned char *p, size_t n){
+    size_t i = 0;
+    while (i < n && !s->member[p[i]]) i++;
+    return i;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("ssse3")))
+static size_t span_ssse3(const ByteSet *s, const unsigned char *p, size_t n){
+    const __m128i t0 = _mm_loadu_si128((const __m128i *)s->lo[0]);
+    const __m128i t1 = _mm_loadu_si128((const __m128i *)s->lo[1]);
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i nib = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i lo = _mm_and_si128(v, nib);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nib);
+        __m128i top = _mm_cmplt_epi8(v, _mm_setzero_si128()); // bytes >= 0x80 use lo[1]
+        __m128i row = _mm_or_si128(_mm_andnot_si128(top, _mm_shuffle_epi8(t0, lo)),
+                                   _mm_and_si128(top, _mm_shuffle_epi8(t1, lo)));
+        __m128i bit = _mm_shuffle_epi8(bits, hi);
+        int m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    return i + span_scalar(s, p + i, n - i);
+}
+static int have_ssse3(void){ return __builtin_cpu_supports("ssse3"); }
+#else
+static size_t span_ssse3(const ByteSet *s, const unsigned char *p, size_t n){ return span_scalar(s, p, n); }
+static int have_ssse3(void){ return 0; }
+#endif
+
+// Length of the prefix of p[0..n) holding no member of s.
+static size_t (*byteset_span)(const ByteSet *, const unsigned char *, size_t) = span_scalar;
+
+// ---- set syntax ----
+
+typedef struct { unsigned char b[TR_SET_MAX]; int n; } Set;
+
+static const struct { const char *name; int (*fn)(int); } classes[] = {
+    { "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank }, { "cntrl", iscntrl },
+    { "digit", isdigit }, { "graph", isgraph }, { "lower", islower }, { "print", isprint },
+    { "punct", ispunct }, { "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit },
+};
+
+static int set_push(Set *s, int c){
+    if (s->n == TR_SET_MAX) return -1;
+    s->b[s->n++] = (unsigned char)c;
+    return 0;
+}
+
+// One possibly escaped byte at *sp; advances *sp.
+static int next_byte(const char **sp){
+    const unsigned char *p = (const unsigned char *)*sp;
+    int c = *p++;
+    if (c == '\\' && *p) {
+        c = *p++;
+        switch (c) {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'a': c = '\a'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'v': c = '\v'; break;
+        default:
+            if (c >= '0' && c <= '7') {
+                c -= '0';
+                for (int k = 0; k < 2 && *p >= '0' && *p <= '7'; k++) c = c * 8 + (*p++ - '0');
+                c &= 0xff;
+            }
+        }
+    }
+    *sp = (const char *)p;
+    return c;
+}
+
+static int parse_set(const char *spec, Set *s){
+    s->n = 0;
+    const char *p = spec;
+    while (*p) {
+        if (p[0] == '[' && p[1] == ':') {
+            const char *end = strstr(p + 2, ":]");
+            size_t len = end ? (size_t)(end - p - 2) : 0;
+            size_t k = 0;
+            for (; end && k < sizeof(classes) / sizeof(classes[0]); k++)
+                if (strlen(classes[k].name) == len && strncmp(p + 2, classes[k].name, len) == 0) break;
+            if (!end || k == sizeof(classes) / sizeof(classes[0])) return -1;
+            for (int c = 0; c < 256; c++)
+                if (classes[k].fn(c) && set_push(s, c) != 0) return -1;
+            p = end + 2;
+            continue;
+        }
+        int lo = next_byte(&p);
+        if (p[0] == '-' && p[1]) {
+            p++;
+            int hi = next_byte(&p);
+            if (hi < lo) return -1;
+            for (int c = lo; c <= hi; c++)
+                if (set_push(s, c) != 0) return -1;
+        } else if (set_push(s, lo) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void complement(Set *s){
+    unsigned char in[256] = { 0 };
+    for (int i = 0; i < s->n; i++) in[s->b[i]] = 1;
+    s->n = 0;
+    for (int c = 0; c < 256; c++) if (!in[c]) s->b[s->n++] = (unsigned char)c;
+}
+
+// ---- filter ----
+
+typedef struct {
+    unsigned char map[256];
+    ByteSet changed;  // bytes the map does not leave alone
+    ByteSet del;
+    ByteSet squeeze;
+    int last;         // last byte written if it is in squeeze, else -1
+} Tr;
+
+// Apply t to p[0..n) in place; returns the new length.
+static size_t tr_block(Tr *t, unsigned char *p, size_t n){
+    size_t r = 0, w = 0;
+    if (!t->changed.empty) {
+        while (r < n) {
+            r += byteset_span(&t->changed, p + r, n - r);
+            // Map a whole run from there: when most bytes change (tr a-z A-Z
+            // on text) this is a plain table loop, not a search per byte.
+            size_t stop = n - r > TR_RUN ? r + TR_RUN : n;
+            for (; r < stop; r++) p[r] = t->map[p[r]];
+        }
+    } else if (!t->del.empty) {
+        while (r < n) {
+            size_t k = byteset_span(&t->del, p + r, n - r);
+            if (w != r) memmove(p + w, p + r, k);
+            w += k;
+            r += k;
+            while (r < n && t->del.member[p[r]]) r++;
+        }
+        n = w;
+    }
+    if (!t->squeeze.empty) {
+        r = w = 0;
+        while (r < n) {
+            size_t k = byteset_span(&t->squeeze, p + r, n - r);
+            if (k) {
+                if (w != r) memmove(p + w, p + r, k);
+                w += k;
+                r += k;
+                t->last = -1;
+                if (r == n) break;
+            }
+            unsigned char c = p[r++];
+            if (t->last != c) p[w++] = c;
+            t->last = c;
+        }
+        n = w;
+    }
+    return n;
+}
+
+int run_tr_argv(int argc, char **argv){
+    int comp = 0, del = 0, sq = 0, i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        const char *f = argv[i] + 1;
+        if (strspn(f, "cCds") != strlen(f)) break; // e.g. "-x" as a set
+        comp |= strpbrk(f, "cC") != NULL;
+        del |= strchr(f, 'd') != NULL;
+        sq |= strchr(f, 's') != NULL;
+    }
+    int nsets = argc - i;
+    // Valid shapes: map (2 sets), -d (1), -s (1 or 2), -ds (2).
+    int ok = nsets == 2 ? (!del || sq) : nsets == 1 ? (del != sq) : 0;
+    static Set s1, s2;
+    if (!ok || parse_set(argv[i], &s1) != 0 || (nsets == 2 && parse_set(argv[i + 1], &s2) != 0)
+        || (nsets == 2 && !del && s2.n == 0 && s1.n > 0)) {
+        out_puts(out_stdout(), "tr: Invalid Syntax!");
+        return 1;
+    }
+    if (comp) complement(&s1);
+
+    Tr t;
+    for (int c = 0; c < 256; c++) t.map[c] = (unsigned char)c;
+    byteset_init(&t.changed);
+    byteset_init(&t.del);
+    byteset_init(&t.squeeze);
+    t.last = -1;
+    if (del) {
+        for (int k = 0; k < s1.n; k++) byteset_add(&t.del, s1.b[k]);
+    } else if (nsets == 2) {
+        for (int k = 0; k < s1.n; k++) t.map[s1.b[k]] = s2.b[k < s2.n ? k : s2.n - 1];
+        for (int c = 0; c < 256; c++) if (t.map[c] != c) byteset_add(&t.changed, (unsigned char)c);
+    }
+    if (sq) {
+        const Set *s = nsets == 2 ? &s2 : &s1;
+        for (int k = 0; k < s->n; k++) byteset_add(&t.squeeze, s->b[k]);
+    }
+    if (have_ssse3()) byteset_span = span_ssse3;
+
+    out_flush_all(); // a prompt printed just before must be visible
+    unsigned char *buf = malloc(TR_BLOCK);
+    if (!buf) return 1;
+    signals_take_interrupt(); // forget a Ctrl-C typed before this command
+    int rc = 0;
+    OutBuf *out = out_stdout();
+    for (;;) {
+        ssize_t n = lr_read_block(STDIN_FILENO, (char *)buf, TR_BLOCK);
+        if (signals_take_interrupt()) { rc = 1; break; }
+        if (n == -2) { rc = 1; break; }
+        if (n == 0) break;
+        size_t len = tr_block(&t, buf, (size_t)n);
+        out_write(out, (const char *)buf, len);
+    }
+    free(buf);
+    out_flush(out);
+    return rc;
+}
@@ -0,0 +1,359 @@
+// usage.c: du -s as a builtin
+// ---------------------------
+// Implements: usage [-b] [-f] [-j] [path...]
+//   usage            -> "1.4G\t." for the current directory
+//   usage -b logs    -> apparent size in bytes (sum of file sizes), like du -sb
+//   usage -j build   -> {"path":"build","bytes":...,"dirs":...,"rescanned":...}
+//
+// Sizes are allocated blocks (st_blocks * 512), like du; -b sums st_size
+// instead, so sparse files count in full and small files less than a block.
+// Symlinks are not followed and hard-linked files are counted at every name.
+//
+// Walker: a pool of threads shares a stack of directories. Each directory is
+// opened relative to its parent's descriptor (openat), read with
+// getdents64() and its entries sized with statx() relative to it, so no
+// path is ever resolved from the root again. A parent's descriptor stays open
+// until the last child has been opened.
+//
+// Cache: for every directory (by device + inode) we remember its mtime, the
+// total of its non-directory entries and the names of its subdirectories.
+// Adding, removing or renaming an entry changes the directory's mtime; while
+// it doesn't change, we reuse the cached total and only descend into the
+// subdirectories, so a repeat query rescans only changed subtrees. A file
+// that grows in place does not touch its directory's mtime: use -f for an
+// exact full rescan.
+#define _GNU_SOURCE // statx(), O_NOFOLLOW, syscall()
+#include "usage.h"
+#include "dirs.h"
+#include "json.h"
+#include "outbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h> // DT_DIR
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define USAGE_MAX_THREADS 16
+#define USAGE_CACHE_BUCKETS 4096
+#define USAGE_CACHE_MAX 200000 // directories remembered before the cache is reset
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// ---- directory cache ----
+
+typedef struct CacheDir {
+    uint64_t dev, ino;
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint64_t own_bytes; // allocated bytes of all non-directory entries
+    uint64_t own_size;  // their apparent size (st_size)
+    char **subdirs;
+    int nsub;
+    struct CacheDir *next;
+} CacheDir;
+
+static CacheDir *cache[USAGE_CACHE_BUCKETS];
+static long cache_count = 0;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void free_cache_dir(CacheDir *c){
+    for (int i = 0; i < c->nsub; i++) free(c->subdirs[i]);
+    free(c->subdirs);
+    free(c);
+}
+
+static void cache_clear(void){
+    for (int b = 0; b < USAGE_CACHE_BUCKETS; b++) {
+        CacheDir *c = cache[b];
+        while (c) { CacheDir *next = c->next; free_cache_dir(c); c = next; }
+        cache[b] = NULL;
+    }
+    cache_count = 0;
+}
+
+static unsigned bucket_of(uint64_t dev, uint64_t ino){
+    return (unsigned)((ino * 0x9E3779B97F4A7C15ULL) ^ dev) % USAGE_CACHE_BUCKETS;
+}
+
+// Caller holds cache_lock.
+static CacheDir *cache_find(uint64_t dev, uint64_t ino){
+    for (CacheDir *c = cache[bucket_of(dev, ino)]; c; c = c->next)
+        if (c->dev == dev && c->ino == ino) return c;
+    return NULL;
+}
+
+// Store (or replace) the entry for a directory; takes ownership of c.
+static void cache_store(CacheDir *c){
+    pthread_mutex_lock(&cache_lock);
+    if (cache_count >= USAGE_CACHE_MAX) cache_clear();
+    unsigned b = bucket_of(c->dev, c->ino);
+    CacheDir **pp = &cache[b];
+    while (*pp && !((*pp)->dev == c->dev && (*pp)->ino == c->ino)) pp = &(*pp)->next;
+    if (*pp) {
+        CacheDir *old = *pp;
+        c->next = old->next;
+        *pp = c;
+        free_cache_dir(old);
+    } else {
+        c->next = cache[b];
+        cache[b] = c;
+        cache_count++;
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+// ---- walker ----
+
+typedef struct DirRef {
+    int fd;
+    int refs; // the directory itself + its queued children
+} DirRef;
+
+typedef struct Task {
+    DirRef *parent; // NULL for the root: name is then relative to the shell cwd
+    char *name;
+    struct Task *next;
+} Task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    Task *stack;    // LIFO keeps the walk depth-first and few fds open
+    int active;     // tasks currently being processed
+    uint64_t bytes, size; // allocated and apparent
+    long dirs, rescanned;
+    int root_failed;
+    int use_cache;
+} Walk;
+
+static void ref_release(Walk *w, DirRef *r){
+    if (!r) return;
+    pthread_mutex_lock(&w->lock);
+    int last = --r->refs == 0;
+    pthread_mutex_unlock(&w->lock);
+    if (last) { close(r->fd); free(r); }
+}
+
+static void push_task(Walk *w, DirRef *parent, const char *name){
+    Task *t = malloc(sizeof(*t));
+    char *n = strdup(name);
+    if (!t || !n) { free(t); free(n); return; }
+    t->parent = parent;
+    t->name = n;
+    pthread_mutex_lock(&w->lock);
+    if (parent) parent->refs++;
+    t->next = w->stack;
+    w->stack = t;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static uint64_t statx_dev(const struct statx *sx){
+    return ((uint64_t)sx->stx_dev_major << 32) | sx->stx_dev_minor;
+}
+
+// Read all entries of dirfd: size the non-directories, collect subdirectory
+// names into c.
+static void scan_dir(int dirfd, CacheDir *c){
+    char buf[32768];
+    int cap = 0;
+    for (;;) {
+        long n = syscall(SYS_getdents64, dirfd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (long off = 0; off < n; ) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(buf + off);
+            off += d->d_reclen;
+            const char *name = d->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            int is_dir = d->d_type == DT_DIR;
+            if (!is_dir) {
+                struct statx sx;
+                if (statx(dirfd, name, AT_SYMLINK_NOFOLLOW, STATX_TYPE | STATX_BLOCKS | STATX_SIZE, &sx) != 0) continue;
+                if (S_ISDIR(sx.stx_mode)) is_dir = 1; // DT_UNKNOWN filesystems
+                else { c->own_bytes += sx.stx_blocks * 512; c->own_size += sx.stx_size; continue; }
+            }
+            if (c->nsub == cap) {
+                int ncap = cap ? cap * 2 : 8;
+                char **ns = realloc(c->subdirs, (size_t)ncap * sizeof(char *));
+                if (!ns) continue;
+                c->subdirs = ns; cap = ncap;
+            }
+            char *dup = strdup(name);
+            if (dup) c->subdirs[c->nsub++] = dup;
+        }
+    }
+}
+
+static void process(Walk *w, Task *t){
+    int base = t->parent ? t->parent->fd : dirs_cwd_fd();
+    // The root may be a symlink to a directory; nothing below it is followed.
+    int fd = openat(base, t->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (t->parent ? O_NOFOLLOW : 0));
+    ref_release(w, t->parent);
+    if (fd < 0) {
+        if (!t->parent) w->root_failed = 1;
+        return;
+    }
+    struct statx sx;
+    if (statx(fd, "", AT_EMPTY_PATH, STATX_BLOCKS | STATX_SIZE | STATX_MTIME | STATX_INO, &sx) != 0) {
+        close(fd);
+        return;
+    }
+    DirRef *me = malloc(sizeof(*me));
+    if (!me) { close(fd); return; }
+    me->fd = fd;
+    me->refs = 1;
+
+    uint64_t dev = statx_dev(&sx), ino = sx.stx_ino;
+    uint64_t bytes = sx.stx_blocks * 512, size = sx.stx_size;
+    int rescanned = 0;
+
+    int hit = 0;
+    if (w->use_cache) {
+        pthread_mutex_lock(&cache_lock);
+        CacheDir *c = cache_find(dev, ino);
+        if (c && c->mtime_sec == sx.stx_mtime.tv_sec && c->mtime_nsec == sx.stx_mtime.tv_nsec) {
+            hit = 1;
+            bytes += c->own_bytes;
+            size += c->own_size;
+            for (int i = 0; i < c->nsub; i++) push_task(w, me, c->subdirs[i]);
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+    if (!hit) {
+        CacheDir *c = calloc(1, sizeof(*c));
+        if (c) {
+            c->dev = dev; c->ino = ino;
+            c->mtime_sec = sx.stx_mtime.tv_sec;
+            c->mtime_nsec = sx.stx_mtime.tv_nsec;
+            scan_dir(fd, c);
+            bytes += c->own_bytes;
+            size += c->own_size;
+            for (int i = 0; i < c->nsub; i++) push_task(w, me, c->subdirs[i]);
+            cache_store(c);
+        }
+        rescanned = 1;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    w->bytes += bytes;
+    w->size += size;
+    w->dirs++;
+    w->rescanned += rescanned;
+    pthread_mutex_unlock(&w->lock);
+    ref_release(w, me);
+}
+
+static void *worker(void *arg){
+    Walk *w = arg;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (!w->stack && w->active > 0) pthread_cond_wait(&w->cond, &w->lock);
+        if (!w->stack) break; // nothing queued and nobody can queue more
+        Task *t = w->stack;
+        w->stack = t->next;
+        w->active++;
+        pthread_mutex_unlock(&w->lock);
+        process(w, t);
+        free(t->name);
+        free(t);
+        pthread_mutex_lock(&w->lock);
+        w->active--;
+        if (!w->stack && w->active == 0) pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+static int walk_threads(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    // Mostly waiting on metadata I/O: use more threads than CPUs.
+    n = n > 0 ? n * 2 : 2;
+    if (n < 2) n = 2;
+    if (n > USAGE_MAX_THREADS) n = USAGE_MAX_THREADS;
+    return (int)n;
+}
+
+static int walk(const char *path, int use_cache, Walk *w){
+    memset(w, 0, sizeof(*w));
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    w->use_cache = use_cache;
+    push_task(w, NULL, path);
+
+    pthread_t tids[USAGE_MAX_THREADS];
+    int nthreads = walk_threads() - 1, started = 0; // this thread works too
+    for (int i = 0; i < nthreads; i++)
+        if (pthread_create(&tids[started], NULL, worker, w) == 0) started++;
+    worker(w);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    return w->root_failed ? -1 : 0;
+}
+
+static void human_size(uint64_t bytes, char *out, size_t n){
+    const char *units = "KMGTPE";
+    if (bytes < 1024) { snprintf(out, n, "%llu", (unsigned long long)bytes); return; }
+    double v = (double)bytes;
+    int u = -1;
+    while (v >= 1024 && u < 5) { v /= 1024; u++; }
+    if (v < 10) snprintf(out, n, "%.1f%c", v, units[u]);
+    else snprintf(out, n, "%.0f%c", v, units[u]);
+}
+
+int run_usage_argv(int argc, char **argv){
+    int apparent = 0, use_cache = 1, as_json = json_default();
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-' && argv[first][1]; first++) {
+        for (const char *f = argv[first] + 1; *f; f++) {
+            if (*f == 'b') apparent = 1;
+            else if (*f == 'f') use_cache = 0;
+            else if (*f == 'j') as_json = 1;
+            else { out_puts(out_stdout(), "usage: Invalid Syntax!"); return 1; }
+        }
+    }
+    static char *dot[] = { ".", NULL };
+    char **paths = first < argc ? &argv[first] : dot;
+    int npaths = first < argc ? argc - first : 1;
+
+    JsonWriter jw;
+    if (as_json) json_init(&jw, out_stdout());
+    int rc = 0;
+    for (int i = 0; i < npaths; i++) {
+        Walk w;
+        if (walk(paths[i], use_cache, &w) != 0) {
+            out_puts(out_stdout(), "No such directory!");
+            rc = 1;
+            continue;
+        }
+        uint64_t bytes = apparent ? w.size : w.bytes;
+        if (as_json) {
+            json_begin(&jw);
+            json_str(&jw, "path", paths[i]);
+            json_int(&jw, "bytes", (long long)bytes);
+            json_int(&jw, "dirs", w.dirs);
+            json_int(&jw, "rescanned", w.rescanned);
+            json_end(&jw);
+        } else {
+            char size[32];
+            if (apparent) snprintf(size, sizeof(size), "%llu", (unsigned long long)bytes);
+            else human_size(bytes, size, sizeof(size));
+            out_printf(out_stdout(), "%s\t%s\n", size, paths[i]);
+        }
+    }
+    if (as_json) json_flush(&jw);
+    else out_flush(out_stdout());
+    return rc;
+}
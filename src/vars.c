@@ -0,0 +1,274 @@
+// vars.c: shell variables
+// -----------------------
+// Variables are set by builtins such as read and expanded in command words:
+//   read name rest < file
+//   echo $name ${rest}
+// A small hash table maps names to values. Names that were never set fall
+// back to the environment, so $HOME and $PATH work too. Variables are not
+// exported to child processes.
+//
+// Indexed arrays (filled by mapfile) keep all elements in one buffer plus a
+// table of offsets, so a 100k-line file is two allocations, not 100k:
+//   ${a[2]}     one element        ${#a[@]}  number of elements
+//   ${a[@]}     every element as its own word (joined by spaces inside a
+//               longer word); $a is the same as ${a[0]}
+#define _POSIX_C_SOURCE 200809L
+#include "vars.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+
+#define VARS_BUCKETS 64
+
+typedef struct Var {
+    char *name;
+    char *value;  // scalar value, NULL for arrays
+    char *data;   // array elements: data[offs[i]..offs[i+1])
+    size_t *offs; // count + 1 entries
+    size_t count;
+    int trim;     // strip this trailing byte from elements, -1 for none
+    struct Var *next;
+} Var;
+
+static Var *table[VARS_BUCKETS];
+
+static unsigned bucket_of(const char *s, size_t n){
+    unsigned h = 2166136261u;
+    for (size_t i = 0; i < n; i++) { h ^= (unsigned char)s[i]; h *= 16777619u; }
+    return h % VARS_BUCKETS;
+}
+
+static Var *find(const char *name, size_t n){
+    for (Var *v = table[bucket_of(name, n)]; v; v = v->next)
+        if (strncmp(v->name, name, n) == 0 && v->name[n] == '\0') return v;
+    return NULL;
+}
+
+int vars_valid_name(const char *name){
+    if (!name || !(isalpha((unsigned char)name[0]) || name[0] == '_')) return 0;
+    for (const char *p = name + 1; *p; p++)
+        if (!isalnum((unsigned char)*p) && *p != '_') return 0;
+    return 1;
+}
+
+static void clear_value(Var *v){
+    free(v->value);
+    free(v->data);
+    free(v->offs);
+    v->value = v->data = NULL;
+    v->offs = NULL;
+    v->count = 0;
+}
+
+static Var *find_or_add(const char *name){
+    size_t n = strlen(name);
+    Var *v = find(name, n);
+    if (v) return v;
+    v = calloc(1, sizeof(*v));
+    if (!v || !(v->name = strdup(name))) { free(v); return NULL; }
+    unsigned b = bucket_of(name, n);
+    v->next = table[b];
+    table[b] = v;
+    return v;
+}
+
+void vars_set(const char *name, const char *value){
+    char *copy = strdup(value ? value : "");
+    Var *v = copy ? find_or_add(name) : NULL;
+    if (!v) { free(copy); return; }
+    clear_value(v);
+    v->value = copy;
+}
+
+void vars_set_array(const char *name, char *data, size_t *offs, size_t count, int trim){
+    Var *v = find_or_add(name);
+    if (!v) { free(data); free(offs); return; }
+    clear_value(v);
+    v->data = data;
+    v->offs = offs;
+    v->count = count;
+    v->trim = trim;
+}
+
+// Element i of v (a scalar is a one-element array); NULL past the end.
+static const char *elem(const Var *v, size_t i, size_t *len){
+    if (!v->data) {
+        if (i > 0) return NULL;
+        *len = strlen(v->value);
+        return v->value;
+    }
+    if (i >= v->count) return NULL;
+    const char *s = v->data + v->offs[i];
+    *len = v->offs[i + 1] - v->offs[i];
+    if (v->trim >= 0 && *len && (unsigned char)s[*len - 1] == v->trim) (*len)--;
+    return s;
+}
+
+static const char *lookup_n(const char *name, size_t n, size_t i, size_t *len){
+    Var *v = find(name, n);
+    if (v) return elem(v, i, len);
+    char tmp[256];
+    if (i > 0 || n >= sizeof(tmp)) return NULL;
+    memcpy(tmp, name, n);
+    tmp[n] = '\0';
+    const char *val = getenv(tmp);
+    if (val) *len = strlen(val);
+    return val;
+}
+
+static size_t count_n(const char *name, size_t n){
+    Var *v = find(name, n);
+    size_t len;
+    if (v) return v->data ? v->count : 1;
+    return lookup_n(name, n, 0, &len) ? 1 : 0;
+}
+
+void vars_clear(void){
+    for (int b = 0; b < VARS_BUCKETS; b++) {
+        while (table[b]) {
+            Var *v = table[b];
+            table[b] = v->next;
+            clear_value(v);
+            free(v->name);
+            free(v);
+        }
+    }
+}
+
+struct VarTable {
+    Var *buckets[VARS_BUCKETS];
+};
+
+VarTable *vars_table_new(void){
+    return calloc(1, sizeof(VarTable));
+}
+
+void vars_table_swap(VarTable *t){
+    Var *tmp[VARS_BUCKETS];
+    memcpy(tmp, table, sizeof(tmp));
+    memcpy(table, t->buckets, sizeof(tmp));
+    memcpy(t->buckets, tmp, sizeof(tmp));
+}
+
+void vars_table_free(VarTable *t){
+    if (!t) return;
+    vars_table_swap(t);
+    vars_clear();
+    vars_table_swap(t);
+    free(t);
+}
+
+const char *vars_get(const char *name){
+    Var *v = find(name, strlen(name));
+    if (v) return v->value;
+    return getenv(name);
+}
+
+const char *vars_get_elem(const char *name, size_t i, size_t *len){
+    return lookup_n(name, strlen(name), i, len);
+}
+
+size_t vars_count(const char *name){
+    return count_n(name, strlen(name));
+}
+
+static size_t name_len(const char *p){
+    size_t n = 0;
+    if (!(isalpha((unsigned char)p[0]) || p[0] == '_')) return 0;
+    while (isalnum((unsigned char)p[n]) || p[n] == '_') n++;
+    return n;
+}
+
+int vars_expand_each(const char *word, vars_emit_fn emit, void *ud){
+    if (word[0] != '$' || word[1] != '{') return -1;
+    size_t n = name_len(word + 2);
+    if (!n || strcmp(word + 2 + n, "[@]}") != 0) return -1;
+    size_t len;
+    const char *s;
+    for (size_t i = 0; (s = lookup_n(word + 2, n, i, &len)) != NULL; i++) {
+        int rc = emit(s, len, ud);
+        if (rc) return rc;
+    }
+    return 0;
+}
+
+typedef struct { char *out; size_t len, cap; } Str;
+
+static int put(Str *b, const char *s, size_t n){
+    if (b->len + n + 1 > b->cap) {
+        size_t ncap = b->cap;
+        while (b->len + n + 1 > ncap) ncap *= 2;
+        char *no = realloc(b->out, ncap);
+        if (!no) return -1;
+        b->out = no;
+        b->cap = ncap;
+    }
+    memcpy(b->out + b->len, s, n);
+    b->len += n;
+    return 0;
+}
+
+// Expand the inside of ${...}: name, #name, name[i], name[@], #name[@].
+static int expand_braced(Str *b, const char *in, size_t inlen){
+    int count = in[0] == '#';
+    const char *name = in + count;
+    size_t n = name_len(name), rest = inlen - count - n, len;
+    const char *sub = name + n;
+    char num[24];
+    if (!n) return 0;
+    if (rest == 0) {
+        const char *v = lookup_n(name, n, 0, &len);
+        if (!count) return v ? put(b, v, len) : 0;
+        snprintf(num, sizeof(num), "%zu", v ? len : 0);
+        return put(b, num, strlen(num));
+    }
+    if (sub[0] != '[' || sub[rest - 1] != ']') return 0;
+    if (rest == 3 && (sub[1] == '@' || sub[1] == '*')) {
+        if (count) {
+            snprintf(num, sizeof(num), "%zu", count_n(name, n));
+            return put(b, num, strlen(num));
+        }
+        const char *v;
+        for (size_t i = 0; (v = lookup_n(name, n, i, &len)) != NULL; i++)
+            if ((i && put(b, " ", 1) != 0) || put(b, v, len) != 0) return -1;
+        return 0;
+    }
+    size_t idx = 0;
+    for (size_t k = 1; k + 1 < rest; k++) {
+        if (!isdigit((unsigned char)sub[k])) return 0;
+        idx = idx * 10 + (size_t)(sub[k] - '0');
+    }
+    const char *v = lookup_n(name, n, idx, &len);
+    if (count) {
+        snprintf(num, sizeof(num), "%zu", v ? len : 0);
+        return put(b, num, strlen(num));
+    }
+    return v ? put(b, v, len) : 0;
+}
+
+char *vars_expand(const char *word){
+    if (!strchr(word, '$')) return NULL;
+    Str b = { NULL, 0, strlen(word) + 64 };
+    if (!(b.out = malloc(b.cap))) return NULL;
+    for (const char *p = word; *p; ) {
+        int rc = 0;
+        size_t n;
+        const char *close;
+        if (p[0] == '$' && p[1] == '{' && (close = strchr(p + 2, '}')) != NULL) {
+            rc = expand_braced(&b, p + 2, (size_t)(close - p - 2));
+            p = close + 1;
+        } else if (p[0] == '$' && (n = name_len(p + 1)) > 0) {
+            size_t len;
+            const char *v = lookup_n(p + 1, n, 0, &len);
+            if (v) rc = put(&b, v, len);
+            p += n + 1;
+        } else {
+            rc = put(&b, p, 1); // a lone '$' stays literal
+            p++;
+        }
+        if (rc != 0) { free(b.out); return NULL; }
+    }
+    b.out[b.len] = '\0';
+    return b.out;
+}
@@ -0,0 +1,101 @@
+// parser_scaling.c: adversarial complexity test for the command-line parser
+// ------------------------------------------------------------------------
+// Run with `make test`. Builds lines of up to 1 MiB out of one repeated
+// unit (separator floods, whitespace runs, redirections, pipes, ...) and
+// checks two things for each shape:
+// - the verdict of parse_command() is the expected one, and
+//   parse_command_names() agrees with it;
+// - time scales linearly: a line 4x as long may take at most
+//   SCALE_LIMIT times as long (a quadratic parser would take ~16x).
+// Each size is timed several times and the fastest run counts, so one
+// scheduling hiccup doesn't fail the test.
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SMALL_BYTES (256 * 1024)
+#define LARGE_BYTES (1024 * 1024)
+#define RUNS 5
+#define SCALE_LIMIT 8.0
+
+typedef struct {
+    const char *label;
+    const char *head, *unit, *tail;
+    int valid; // expected verdict
+} Shape;
+
+static const Shape shapes[] = {
+    { "separators",     "a", " ; b",      "",    1 },
+    { "background",     "a", " & b",      "",    1 },
+    { "and-lists",      "a", " && b",     "",    1 },
+    { "pipes",          "a", " | b",      "",    1 },
+    { "spaces",         "a", "         ", "",    1 },
+    { "mixed blanks",   "a", " \t\r\n",   ";",   1 },
+    { "redirections",   "a", " < f > g",  "",    1 },
+    { "appends",        "a", " >> g",     "",    1 },
+    { "late bad pipe",  "a", " ; b",      " |",  0 }, // error only at the very end
+    { "late bad redir", "a", " < f",      " < ", 0 },
+    { "early error",    "a", "        ;", "",    0 }, // rejected at the second ';'
+};
+
+static double now(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+// head + unit repeated to about bytes + tail.
+static char *build(const Shape *sh, size_t bytes){
+    size_t hl = strlen(sh->head), ul = strlen(sh->unit), tl = strlen(sh->tail);
+    size_t n = bytes / ul;
+    char *s = malloc(hl + ul * n + tl + 1);
+    if (!s) { perror("malloc"); exit(2); }
+    memcpy(s, sh->head, hl);
+    for (size_t i = 0; i < n; i++) memcpy(s + hl + i * ul, sh->unit, ul);
+    memcpy(s + hl + ul * n, sh->tail, tl + 1);
+    return s;
+}
+
+static int count_name(const char *name, size_t len, void *ud){
+    (void)name; (void)len;
+    (*(size_t *)ud)++;
+    return 0;
+}
+
+// Fastest of RUNS parses of line, in seconds.
+static double time_parse(const char *line){
+    double best = 0;
+    for (int r = 0; r < RUNS; r++) {
+        double t0 = now();
+        (void)parse_command(line);
+        double t = now() - t0;
+        if (r == 0 || t < best) best = t;
+    }
+    return best;
+}
+
+int main(void){
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        const Shape *sh = &shapes[i];
+        char *small = build(sh, SMALL_BYTES);
+        char *large = build(sh, LARGE_BYTES);
+        int ok = 1;
+        size_t names = 0;
+        if (parse_command(large) != sh->valid) ok = 0;
+        if ((parse_command_names(large, count_name, &names) == 0) != sh->valid) ok = 0;
+        double ts = time_parse(small), tl = time_parse(large);
+        // Below a few microseconds the ratio is noise, not complexity.
+        double ratio = ts > 1e-6 ? tl / ts : 1.0;
+        if (ratio > SCALE_LIMIT) ok = 0;
+        printf("%-4s %-15s %8.2f ms %8.2f ms  x%.1f\n", ok ? "ok" : "FAIL",
+               sh->label, ts * 1e3, tl * 1e3, ratio);
+        if (!ok) failed++;
+        free(small);
+        free(large);
+    }
+    if (failed) printf("%d of %zu shapes failed\n", failed, sizeof(shapes) / sizeof(shapes[0]));
+    return failed ? 1 : 0;
+}